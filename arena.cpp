@@ -0,0 +1,86 @@
+#include "arena.hpp"
+
+// system includes
+#include <atomic>
+#include <cassert>
+#include <new>
+
+// allocations are rounded up to keep every one aligned
+static const std::size_t ALIGNMENT = alignof(std::max_align_t);
+
+const std::size_t NodeArena::CHUNK_SIZE = 64 * 1024 - 64;
+
+struct NodeArena::Chunk {
+  // one for each live allocation, plus one while an arena holds the chunk
+  std::atomic<std::size_t> refs;
+  std::size_t used;
+  alignas(std::max_align_t) unsigned char data[CHUNK_SIZE];
+
+  Chunk(): refs(1), used(0) {}
+};
+
+// set by Scope
+static thread_local NodeArena * current_arena = nullptr;
+
+NodeArena::NodeArena() noexcept {}
+
+NodeArena::NodeArena(const NodeArena &) noexcept {}
+
+NodeArena & NodeArena::operator=(const NodeArena & other) noexcept{
+
+  if(this != &other){
+    release();
+  }
+  return *this;
+}
+
+NodeArena::~NodeArena(){
+  release();
+}
+
+void * NodeArena::allocate(std::size_t size, Chunk *& owner){
+
+  assert(size <= CHUNK_SIZE);
+
+  size = (size + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+  if(m_chunks.empty() || (m_chunks.back()->used + size > CHUNK_SIZE)){
+    m_chunks.push_back(new Chunk());
+  }
+
+  owner = m_chunks.back();
+  void * memory = owner->data + owner->used;
+  owner->used += size;
+  owner->refs.fetch_add(1, std::memory_order_relaxed);
+  return memory;
+}
+
+void NodeArena::free(Chunk * owner) noexcept{
+
+  if(owner->refs.fetch_sub(1, std::memory_order_acq_rel) == 1){
+    delete owner;
+  }
+}
+
+void NodeArena::release() noexcept{
+
+  for(auto chunk : m_chunks){
+    free(chunk);
+  }
+  m_chunks.clear();
+}
+
+std::size_t NodeArena::chunks() const noexcept{
+  return m_chunks.size();
+}
+
+NodeArena::Scope::Scope(NodeArena & arena) noexcept: previous(current_arena){
+  current_arena = &arena;
+}
+
+NodeArena::Scope::~Scope(){
+  current_arena = previous;
+}
+
+NodeArena * NodeArena::current() noexcept{
+  return current_arena;
+}
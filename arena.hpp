@@ -0,0 +1,93 @@
+/*! \file arena.hpp
+Defines the arena the parser allocates the nodes of an AST from.
+ */
+#ifndef ARENA_HPP
+#define ARENA_HPP
+
+// system includes
+#include <cstddef>
+#include <vector>
+
+/*! \class NodeArena
+\brief A bump allocator handing out memory from large chunks.
+
+Parsing allocates many small tail blocks that are freed together when the
+AST is replaced. Allocating them from an arena turns each into a pointer
+increment, and release gives all of them back at once.
+
+Nodes may outlive the AST they were parsed into, e.g. a lambda body bound in
+the environment shares its tail with the AST. Each chunk therefore counts
+its live allocations and is freed only when the arena has released it and
+the last of them has been freed.
+
+While a Scope is active, expressions created on that thread allocate their
+tail blocks from its arena.
+ */
+class NodeArena {
+public:
+
+  /// the unit of allocation, opaque outside the arena
+  struct Chunk;
+
+  /// Construct an empty arena
+  NodeArena() noexcept;
+
+  /// copying gives an empty arena, nodes allocated so far stay with the original
+  NodeArena(const NodeArena & other) noexcept;
+
+  /// assigning releases this arena, nodes allocated so far stay valid
+  NodeArena & operator=(const NodeArena & other) noexcept;
+
+  /// release the arena
+  ~NodeArena();
+
+  /*! Allocate memory
+    \param size the number of bytes, at most CHUNK_SIZE
+    \param owner set to the chunk the memory came from, to be passed to free
+    \return memory aligned for any fundamental type
+   */
+  void * allocate(std::size_t size, Chunk *& owner);
+
+  /*! Mark an allocation dead, freeing its chunk if it was the last live one
+    and the arena has released it. This is safe to call from any thread.
+    \param owner the chunk set by allocate
+   */
+  static void free(Chunk * owner) noexcept;
+
+  /// give up all chunks, each is freed once its allocations are
+  void release() noexcept;
+
+  /// the number of chunks held by the arena
+  std::size_t chunks() const noexcept;
+
+  /// the usable bytes in a chunk
+  static const std::size_t CHUNK_SIZE;
+
+  /*! \class Scope
+    \brief Makes an arena current on this thread for its lifetime.
+   */
+  class Scope {
+  public:
+    /// make arena current
+    explicit Scope(NodeArena & arena) noexcept;
+
+    /// restore the arena current before
+    ~Scope();
+
+    Scope(const Scope &) = delete;
+    Scope & operator=(const Scope &) = delete;
+
+  private:
+    NodeArena * previous;
+  };
+
+  /// the current arena of this thread, or nullptr
+  static NodeArena * current() noexcept;
+
+private:
+
+  // the chunks in allocation order, the last one is being filled
+  std::vector<Chunk *> m_chunks;
+};
+
+#endif
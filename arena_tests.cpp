@@ -0,0 +1,96 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+
+#include "arena.hpp"
+#include "environment.hpp"
+#include "interpreter.hpp"
+#include "parse.hpp"
+
+static Expression parse_into(const std::string & program, NodeArena & arena){
+
+  std::istringstream iss(program);
+  return parse(tokenize(iss), arena);
+}
+
+TEST_CASE( "Test arena allocation", "[arena]" ) {
+
+  NodeArena arena;
+  REQUIRE(arena.chunks() == 0);
+
+  NodeArena::Chunk * first = nullptr;
+  NodeArena::Chunk * second = nullptr;
+  char * a = static_cast<char *>(arena.allocate(1, first));
+  char * b = static_cast<char *>(arena.allocate(24, second));
+  REQUIRE(arena.chunks() == 1);
+  REQUIRE(first == second);
+  REQUIRE(a != b);
+  REQUIRE(reinterpret_cast<std::size_t>(b) % alignof(std::max_align_t) == 0);
+
+  NodeArena::Chunk * third = nullptr;
+  arena.allocate(NodeArena::CHUNK_SIZE, third);
+  REQUIRE(arena.chunks() == 2);
+  REQUIRE(third != first);
+
+  NodeArena::free(first);
+  NodeArena::free(second);
+  NodeArena::free(third);
+  arena.release();
+  REQUIRE(arena.chunks() == 0);
+
+  NodeArena copy(arena);
+  REQUIRE(copy.chunks() == 0);
+}
+
+TEST_CASE( "Test the current arena", "[arena]" ) {
+
+  REQUIRE(NodeArena::current() == nullptr);
+
+  NodeArena outer;
+  NodeArena inner;
+  {
+    NodeArena::Scope a(outer);
+    REQUIRE(NodeArena::current() == &outer);
+    {
+      NodeArena::Scope b(inner);
+      REQUIRE(NodeArena::current() == &inner);
+    }
+    REQUIRE(NodeArena::current() == &outer);
+  }
+  REQUIRE(NodeArena::current() == nullptr);
+}
+
+TEST_CASE( "Test parsing into an arena", "[arena]" ) {
+
+  std::string program = "(begin (define f (lambda (x) (list x (+ x 1)))) (f 2))";
+
+  NodeArena arena;
+  Expression ast = parse_into(program, arena);
+  REQUIRE(arena.chunks() == 1);
+
+  std::istringstream iss(program);
+  REQUIRE(ast == parse(tokenize(iss)));
+
+  INFO("nodes outlive the arena and the AST they were parsed into");
+  Expression body = *(ast.tail());
+  arena.release();
+  ast = Expression();
+  REQUIRE(body == parse_into("(f 2)", arena));
+}
+
+TEST_CASE( "Test definitions outlive the program they were parsed from", "[arena]" ) {
+
+  Interpreter interp;
+
+  std::istringstream first("(define f (lambda (x) (begin (define y (list x 1)) (+ x 2))))");
+  REQUIRE(interp.parseStream(first) == true);
+  interp.evaluate();
+
+  // replacing the AST releases the arena the lambda body was parsed into
+  for(int i = 0; i < 3; ++i){
+    std::istringstream next("(f 3)");
+    REQUIRE(interp.parseStream(next) == true);
+    REQUIRE(interp.evaluate() == Expression(5.));
+  }
+}
@@ -0,0 +1,455 @@
+#include "ast_cache.hpp"
+
+// system includes
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <unordered_map>
+#include <vector>
+
+#if defined(__APPLE__) || defined(__linux) || defined(__unix) || defined(__posix)
+#define AST_CACHE_POSIX
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+// the format of the entries, changed whenever the layout changes so entries
+// written by another version are replaced
+const char ENTRY_MAGIC[8] = {'P', 'L', 'S', 'A', 'S', 'T', '\0', 2};
+
+// the suffix of entry file names
+const std::string ENTRY_SUFFIX = ".plsast";
+
+// the entry header: magic, source size, AST size. The source follows it,
+// then the AST
+const std::size_t HEADER_SIZE = 8 + 2 * sizeof(std::uint64_t);
+
+// the kinds of node in a serialized AST
+enum NodeKind : unsigned char { NumberNode, SymbolNode };
+
+std::uint64_t source_hash(const char * data, std::size_t size) noexcept{
+
+  // MurmurHash64A, eight bytes at a time
+  const std::uint64_t m = 0xc6a4a7935bd1e995ULL;
+  const int r = 47;
+
+  std::uint64_t h = 0x5bd1e9955bd1e995ULL ^ (size * m);
+
+  std::size_t words = size / 8;
+  for(std::size_t i = 0; i < words; ++i){
+    std::uint64_t k;
+    std::memcpy(&k, data + 8 * i, 8);
+    k *= m;
+    k ^= k >> r;
+    k *= m;
+    h ^= k;
+    h *= m;
+  }
+
+  std::size_t rest = size % 8;
+  if(rest > 0){
+    std::uint64_t k = 0;
+    std::memcpy(&k, data + 8 * words, rest);
+    h ^= k;
+    h *= m;
+  }
+
+  h ^= h >> r;
+  h *= m;
+  h ^= h >> r;
+
+  return h;
+}
+
+static void put_varint(std::string & out, std::uint64_t value){
+
+  while(value >= 0x80){
+    out.push_back(static_cast<char>((value & 0x7f) | 0x80));
+    value >>= 7;
+  }
+  out.push_back(static_cast<char>(value));
+}
+
+static void put_number(std::string & out, double value){
+
+  char bytes[sizeof(double)];
+  std::memcpy(bytes, &value, sizeof(double));
+  out.append(bytes, sizeof(double));
+}
+
+// the tail of a node, packed or not
+static std::size_t tail_size(const Expression & exp){
+
+  const std::vector<double> * packed = exp.packedNumbers();
+  if(packed != nullptr){
+    return packed->size();
+  }
+  return static_cast<std::size_t>(exp.tailConstEnd() - exp.tailConstBegin());
+}
+
+bool serialize_ast(const Expression & ast, std::string & out){
+
+  // the nodes in preorder, walked with a stack so depth is not limited by
+  // the call stack
+  std::vector<const Expression *> nodes;
+  std::vector<const Expression *> stack = {&ast};
+  while(!stack.empty()){
+    const Expression * node = stack.back();
+    stack.pop_back();
+    nodes.push_back(node);
+    if(node->packedNumbers() == nullptr){
+      for(auto it = node->tailConstEnd(); it != node->tailConstBegin(); ){
+	--it;
+	stack.push_back(&*it);
+      }
+    }
+  }
+
+  // the symbol table, by interned id
+  std::unordered_map<std::size_t, std::uint64_t> index;
+  std::vector<const std::string *> symbols;
+  for(const Expression * node : nodes){
+    const Atom & head = node->head();
+    if(head.isSymbol()){
+      if(index.emplace(head.symbolId(), symbols.size()).second){
+	symbols.push_back(&head.asSymbol());
+      }
+    }
+    else if(!head.isNumber()){
+      return false;
+    }
+  }
+
+  put_varint(out, symbols.size());
+  for(const std::string * name : symbols){
+    put_varint(out, name->size());
+    out.append(*name);
+  }
+
+  for(const Expression * node : nodes){
+    const Atom & head = node->head();
+    if(head.isSymbol()){
+      out.push_back(static_cast<char>(SymbolNode));
+      put_varint(out, index[head.symbolId()]);
+    }
+    else{
+      out.push_back(static_cast<char>(NumberNode));
+      put_number(out, head.asNumber());
+    }
+    put_varint(out, tail_size(*node));
+
+    // the elements of a packed list are leaves, next in preorder
+    const std::vector<double> * packed = node->packedNumbers();
+    if(packed != nullptr){
+      for(double value : *packed){
+	out.push_back(static_cast<char>(NumberNode));
+	put_number(out, value);
+	put_varint(out, 0);
+      }
+    }
+  }
+
+  return true;
+}
+
+// reads the bytes of a serialized AST, failing instead of reading past the end
+class ByteReader {
+public:
+  ByteReader(const char * data, std::size_t size): m_data(data), m_size(size), m_pos(0) {}
+
+  bool varint(std::uint64_t & value){
+    value = 0;
+    for(int shift = 0; shift < 64; shift += 7){
+      if(m_pos == m_size) return false;
+      unsigned char byte = static_cast<unsigned char>(m_data[m_pos++]);
+      value |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+      if((byte & 0x80) == 0) return true;
+    }
+    return false;
+  }
+
+  bool byte(unsigned char & value){
+    if(m_pos == m_size) return false;
+    value = static_cast<unsigned char>(m_data[m_pos++]);
+    return true;
+  }
+
+  bool number(double & value){
+    if(m_size - m_pos < sizeof(double)) return false;
+    std::memcpy(&value, m_data + m_pos, sizeof(double));
+    m_pos += sizeof(double);
+    return true;
+  }
+
+  bool bytes(std::size_t count, const char *& start){
+    if(m_size - m_pos < count) return false;
+    start = m_data + m_pos;
+    m_pos += count;
+    return true;
+  }
+
+  // the bytes left, bounding any count read so corrupt input cannot
+  // reserve more than the entry could hold
+  std::size_t remaining() const { return m_size - m_pos; }
+
+private:
+  const char * m_data;
+  std::size_t m_size;
+  std::size_t m_pos;
+};
+
+// read the head and tail size of the next node
+static bool read_node(ByteReader & in, const std::vector<Atom> & symbols,
+		      Atom & head, std::uint64_t & count){
+
+  unsigned char kind;
+  if(!in.byte(kind)) return false;
+
+  if(kind == NumberNode){
+    double value;
+    if(!in.number(value)) return false;
+    head = Atom(value);
+  }
+  else if(kind == SymbolNode){
+    std::uint64_t i;
+    if(!in.varint(i) || i >= symbols.size()) return false;
+    head = symbols[i];
+  }
+  else{
+    return false;
+  }
+
+  // every node takes at least two bytes
+  return in.varint(count) && count <= in.remaining() / 2;
+}
+
+static bool read_ast(ByteReader & in, Expression & ast){
+
+  std::uint64_t count;
+  if(!in.varint(count) || count > in.remaining()) return false;
+
+  std::vector<Atom> symbols;
+  symbols.reserve(count);
+  for(std::uint64_t i = 0; i < count; ++i){
+    std::uint64_t length;
+    const char * name;
+    if(!in.varint(length) || !in.bytes(length, name)) return false;
+    symbols.emplace_back(std::string(name, length));
+  }
+
+  Atom head;
+  if(!read_node(in, symbols, head, count)) return false;
+  ast.setHead(head);
+  ast.reserve(count);
+
+  // the nodes whose tails are being read, and how many expressions each
+  // still needs
+  struct Open { Expression * node; std::uint64_t remaining; };
+  std::vector<Open> stack;
+  if(count > 0) stack.push_back(Open{&ast, count});
+
+  while(!stack.empty()){
+    Open & top = stack.back();
+    if(top.remaining == 0){
+      stack.pop_back();
+      continue;
+    }
+    top.remaining -= 1;
+
+    if(!read_node(in, symbols, head, count)) return false;
+    top.node->append(head);
+    Expression * child = top.node->tail();
+    if(count > 0){
+      child->reserve(count);
+      stack.push_back(Open{child, count});
+    }
+  }
+
+  return in.remaining() == 0;
+}
+
+bool deserialize_ast(const char * data, std::size_t size, Expression & ast) noexcept{
+
+  try{
+    ByteReader in(data, size);
+    Expression result;
+    if(read_ast(in, result)){
+      ast = std::move(result);
+      return true;
+    }
+  }
+  catch(...){
+  }
+  ast = Expression();
+  return false;
+}
+
+AstCache::AstCache(): m_capacity(0){}
+
+AstCache::AstCache(const std::string & directory, std::uint64_t capacity):
+  m_directory(directory), m_capacity(capacity){}
+
+AstCache AstCache::fromEnvironment(){
+
+  const char * directory = std::getenv("PLOTSCRIPT_CACHE_DIR");
+  if(directory == nullptr || *directory == '\0'){
+    return AstCache();
+  }
+
+  std::uint64_t capacity = AST_CACHE_CAPACITY;
+  const char * size = std::getenv("PLOTSCRIPT_CACHE_SIZE");
+  if(size != nullptr && *size != '\0'){
+    char * end;
+    unsigned long long value = std::strtoull(size, &end, 10);
+    if(*end == '\0'){
+      capacity = value;
+    }
+  }
+
+  return AstCache(directory, capacity);
+}
+
+bool AstCache::enabled() const noexcept{
+
+  return !m_directory.empty();
+}
+
+std::string AstCache::entryPath(const SourceBuffer & source) const{
+
+  char name[17];
+  std::snprintf(name, sizeof(name), "%016llx",
+		static_cast<unsigned long long>(source_hash(source.data(), source.size())));
+  return m_directory + "/" + name + ENTRY_SUFFIX;
+}
+
+bool AstCache::load(const SourceBuffer & source, Expression & ast) const noexcept{
+
+  if(!enabled()){
+    return false;
+  }
+
+  try{
+    std::string path = entryPath(source);
+    SourceBuffer entry;
+    if(!entry.open(path)){
+      return false;
+    }
+
+    // the hash only names the entry, the source it was parsed from must
+    // match in full, so programs whose hashes collide never share an AST
+    std::uint64_t header[2] = {0, 0};
+    bool valid = entry.size() >= HEADER_SIZE + source.size() &&
+      std::memcmp(entry.data(), ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0;
+    if(valid){
+      std::memcpy(header, entry.data() + sizeof(ENTRY_MAGIC), sizeof(header));
+      valid = header[0] == source.size() &&
+	header[1] == entry.size() - HEADER_SIZE - source.size() &&
+	std::memcmp(entry.data() + HEADER_SIZE, source.data(), source.size()) == 0;
+    }
+
+    const char * bytes = entry.data() + HEADER_SIZE + source.size();
+    if(valid && deserialize_ast(bytes, static_cast<std::size_t>(header[1]), ast)){
+#ifdef AST_CACHE_POSIX
+      // mark the entry used, eviction removes the least recently used
+      utime(path.c_str(), nullptr);
+#endif
+      return true;
+    }
+
+    std::remove(path.c_str());
+  }
+  catch(...){
+  }
+  return false;
+}
+
+void AstCache::store(const SourceBuffer & source, const Expression & ast) const noexcept{
+
+  if(!enabled()){
+    return;
+  }
+
+  try{
+    std::string bytes(ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    bytes.resize(HEADER_SIZE);
+    bytes.append(source.data(), source.size());
+    if(!serialize_ast(ast, bytes)){
+      return;
+    }
+
+    std::uint64_t header[2] = {source.size(), bytes.size() - HEADER_SIZE - source.size()};
+    std::memcpy(&bytes[sizeof(ENTRY_MAGIC)], header, sizeof(header));
+
+#ifdef AST_CACHE_POSIX
+    mkdir(m_directory.c_str(), 0777);
+    std::string temporary = entryPath(source) + ".tmp" + std::to_string(getpid());
+#else
+    std::string temporary = entryPath(source) + ".tmp";
+#endif
+
+    {
+      std::ofstream ofs(temporary, std::ios::binary | std::ios::trunc);
+      ofs.write(bytes.data(), bytes.size());
+      if(!ofs){
+	ofs.close();
+	std::remove(temporary.c_str());
+	return;
+      }
+    }
+
+    if(std::rename(temporary.c_str(), entryPath(source).c_str()) != 0){
+      std::remove(temporary.c_str());
+      return;
+    }
+
+    evict();
+  }
+  catch(...){
+  }
+}
+
+void AstCache::evict() const{
+
+#ifdef AST_CACHE_POSIX
+  struct Entry { std::string path; std::uint64_t size; time_t used; };
+  std::vector<Entry> entries;
+  std::uint64_t total = 0;
+
+  DIR * dir = opendir(m_directory.c_str());
+  if(dir == nullptr){
+    return;
+  }
+  while(dirent * item = readdir(dir)){
+    std::string name = item->d_name;
+    if(name.size() <= ENTRY_SUFFIX.size() ||
+       name.compare(name.size() - ENTRY_SUFFIX.size(), ENTRY_SUFFIX.size(), ENTRY_SUFFIX) != 0){
+      continue;
+    }
+    std::string path = m_directory + "/" + name;
+    struct stat info;
+    if(stat(path.c_str(), &info) == 0 && S_ISREG(info.st_mode)){
+      entries.push_back(Entry{path, static_cast<std::uint64_t>(info.st_size), info.st_mtime});
+      total += static_cast<std::uint64_t>(info.st_size);
+    }
+  }
+  closedir(dir);
+
+  if(total <= m_capacity){
+    return;
+  }
+
+  std::sort(entries.begin(), entries.end(),
+	    [](const Entry & a, const Entry & b){ return a.used < b.used; });
+  for(const Entry & entry : entries){
+    if(total <= m_capacity) break;
+    if(std::remove(entry.path.c_str()) == 0){
+      total -= entry.size;
+    }
+  }
+#endif
+}
@@ -0,0 +1,112 @@
+/*! \file ast_cache.hpp
+Defines the on-disk cache of parsed programs, so a script that is run
+often is parsed once rather than on every run.
+ */
+#ifndef AST_CACHE_HPP
+#define AST_CACHE_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// module includes
+#include "expression.hpp"
+#include "source.hpp"
+
+/// the bytes of entries an AstCache keeps unless another capacity is given
+const std::uint64_t AST_CACHE_CAPACITY = 256ULL * 1024 * 1024;
+
+/*! \fn source_hash
+\brief A 64-bit hash of the characters of a program, the key of its entry.
+ */
+std::uint64_t source_hash(const char * data, std::size_t size) noexcept;
+
+/*! \fn serialize_ast
+\brief Write an AST in the binary format of the cache entries.
+
+Symbols are stored once in a table and referenced by index, nodes in
+preorder as a head and the number of tail expressions. Numbers are stored
+in host byte order, entries are not meant to be moved between machines.
+
+\param ast the expression to write, as built by parse
+\param out appended to
+\return false if the AST holds an atom that is neither a Number nor a Symbol
+ */
+bool serialize_ast(const Expression & ast, std::string & out);
+
+/*! \fn deserialize_ast
+\brief Read an AST written by serialize_ast.
+
+The nodes are allocated as by parse, from the arena of any active
+NodeArena::Scope.
+
+\param data the first byte
+\param size the number of bytes
+\param ast set to the expression read
+\return false if the bytes are not a complete AST, leaving ast None
+ */
+bool deserialize_ast(const char * data, std::size_t size, Expression & ast) noexcept;
+
+/*! \class AstCache
+\brief A directory of parsed programs, keyed by a hash of their source.
+
+Each entry is a file named by source_hash, holding the source it was
+parsed from and the serialized AST. Entries are loaded by mapping them. An
+edited program has a new key and so misses. The source is compared in full
+on every load, so a program whose hash collides with that of another never
+runs the other's AST. An entry whose source or format version does not
+match, or which is not a complete AST, is removed and treated as a miss.
+
+Storing an entry evicts the least recently used ones, by modification
+time, until the entries total at most the capacity. Loading an entry marks
+it used. Entries are written to a temporary file and renamed into place, so
+several processes may share a directory.
+ */
+class AstCache {
+public:
+
+  /// Construct a disabled cache, which never hits and stores nothing
+  AstCache();
+
+  /*! Construct a cache in a directory, created on the first store if needed
+    \param directory where the entries are kept
+    \param capacity the most bytes of entries to keep
+   */
+  explicit AstCache(const std::string & directory,
+		    std::uint64_t capacity = AST_CACHE_CAPACITY);
+
+  /// the cache in PLOTSCRIPT_CACHE_DIR with capacity PLOTSCRIPT_CACHE_SIZE
+  /// bytes, disabled if the directory is not set
+  static AstCache fromEnvironment();
+
+  /// true if entries are loaded and stored
+  bool enabled() const noexcept;
+
+  /*! Load the AST of a program
+    \param source the text of the program
+    \param ast set to the AST on a hit
+    \return true on a hit
+   */
+  bool load(const SourceBuffer & source, Expression & ast) const noexcept;
+
+  /*! Store the AST of a program, evicting entries over the capacity.
+    Failures to write are ignored, the cache only saves work.
+    \param source the text of the program
+    \param ast the AST parsed from it
+   */
+  void store(const SourceBuffer & source, const Expression & ast) const noexcept;
+
+  /// the file holding the entry of a program
+  std::string entryPath(const SourceBuffer & source) const;
+
+private:
+
+  // remove the least recently used entries until they fit the capacity
+  void evict() const;
+
+  std::string m_directory;
+  std::uint64_t m_capacity;
+};
+
+#endif
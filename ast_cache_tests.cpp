@@ -0,0 +1,213 @@
+#include "catch.hpp"
+
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "ast_cache.hpp"
+#include "interpreter.hpp"
+#include "parse.hpp"
+
+#if defined(__APPLE__) || defined(__linux) || defined(__unix) || defined(__posix)
+#define AST_CACHE_TESTS_POSIX
+#include <utime.h>
+#endif
+
+static Expression parsed(const std::string & program){
+
+  return parse(program.data(), program.size());
+}
+
+TEST_CASE( "Test serializing an AST", "[ast_cache]" ) {
+
+  std::string program = "(begin (define f (lambda (x) (* x 2.5e-3))) "
+    "(list (f -1) \"text\" (list (list (list 1)))) (f 1e300))";
+  Expression ast = parsed(program);
+  REQUIRE(ast != Expression());
+
+  std::string bytes;
+  REQUIRE(serialize_ast(ast, bytes));
+
+  Expression loaded;
+  REQUIRE(deserialize_ast(bytes.data(), bytes.size(), loaded));
+  REQUIRE(loaded.identical(ast));
+
+  // every symbol is stored once, so a repeated program costs little more
+  std::string twice;
+  REQUIRE(serialize_ast(parsed("(list " + program + " " + program + ")"), twice));
+  REQUIRE(twice.size() < 2 * bytes.size());
+
+  // a packed list is loaded as a list of numbers
+  Expression packed(Atom("list"), std::vector<double>{1, 2, 3});
+  bytes.clear();
+  REQUIRE(serialize_ast(packed, bytes));
+  REQUIRE(deserialize_ast(bytes.data(), bytes.size(), loaded));
+  REQUIRE(loaded == parsed("(list 1 2 3)"));
+
+  // only numbers and symbols can be stored
+  bytes.clear();
+  REQUIRE(!serialize_ast(Expression(Atom(std::complex<double>(0, 1))), bytes));
+}
+
+TEST_CASE( "Test deserializing a damaged AST", "[ast_cache]" ) {
+
+  std::string bytes;
+  REQUIRE(serialize_ast(parsed("(+ (* a 2) (- b 3.5))"), bytes));
+
+  Expression loaded;
+  for(std::size_t n = 0; n < bytes.size(); ++n){
+    INFO(n);
+    REQUIRE(!deserialize_ast(bytes.data(), n, loaded));
+    REQUIRE(loaded == Expression());
+  }
+
+  std::string longer = bytes + '\0';
+  REQUIRE(!deserialize_ast(longer.data(), longer.size(), loaded));
+
+  std::string garbage(64, '\x7f');
+  REQUIRE(!deserialize_ast(garbage.data(), garbage.size(), loaded));
+}
+
+TEST_CASE( "Test caching ASTs on disk", "[ast_cache]" ) {
+
+  std::string directory = "ast_cache_tests_scratch";
+
+  SourceBuffer source("(begin (define a 3) (* a a))");
+  SourceBuffer edited("(begin (define a 4) (* a a))");
+
+  {
+    INFO("a disabled cache never hits");
+    AstCache disabled;
+    Expression ast;
+    disabled.store(source, parsed("(begin (define a 3) (* a a))"));
+    REQUIRE(!disabled.load(source, ast));
+  }
+
+  AstCache cache(directory);
+  REQUIRE(cache.enabled());
+
+  {
+    INFO("the interpreter stores on a miss and loads on a hit");
+    Interpreter first;
+    REQUIRE(first.parseSource(source, cache));
+    REQUIRE(first.evaluate() == Expression(9.));
+
+    Expression ast;
+    REQUIRE(cache.load(source, ast));
+    REQUIRE(ast.identical(parsed("(begin (define a 3) (* a a))")));
+
+    Interpreter second;
+    REQUIRE(second.parseSource(source, cache));
+    REQUIRE(second.evaluate() == Expression(9.));
+  }
+
+  {
+    INFO("an edited program misses");
+    Expression ast;
+    REQUIRE(!cache.load(edited, ast));
+    Interpreter interp;
+    REQUIRE(interp.parseSource(edited, cache));
+    REQUIRE(interp.evaluate() == Expression(16.));
+  }
+
+  {
+    INFO("an entry holding another program misses, as on a hash collision");
+    std::rename(cache.entryPath(edited).c_str(), cache.entryPath(source).c_str());
+    Expression ast;
+    REQUIRE(!cache.load(source, ast));
+    REQUIRE(!std::ifstream(cache.entryPath(source)));
+  }
+
+  {
+    INFO("a damaged entry misses and is removed");
+    {
+      std::ofstream ofs(cache.entryPath(source), std::ios::binary | std::ios::trunc);
+      ofs << "PLSAST";
+    }
+    Expression ast;
+    REQUIRE(!cache.load(source, ast));
+    REQUIRE(!std::ifstream(cache.entryPath(source)));
+  }
+
+  {
+    INFO("entries are evicted over the capacity");
+    AstCache full(directory, 0);
+    full.store(source, parsed("(begin (define a 3) (* a a))"));
+    Expression ast;
+    REQUIRE(!full.load(source, ast));
+    REQUIRE(!full.load(edited, ast));
+  }
+
+  std::remove(directory.c_str());
+}
+
+#ifdef AST_CACHE_TESTS_POSIX
+static std::uint64_t file_size(const std::string & path){
+
+  std::ifstream ifs(path, std::ios::binary | std::ios::ate);
+  return ifs ? static_cast<std::uint64_t>(ifs.tellg()) : 0;
+}
+
+static bool exists(const std::string & path){
+
+  return static_cast<bool>(std::ifstream(path));
+}
+
+static void set_used(const std::string & path, time_t when){
+
+  struct utimbuf times = {when, when};
+  REQUIRE(utime(path.c_str(), &times) == 0);
+}
+
+TEST_CASE( "Test evicting the least recently used ASTs", "[ast_cache]" ) {
+
+  std::string directory = "ast_cache_tests_lru";
+
+  std::vector<std::string> programs = {"(+ 1 2)", "(+ 3 4)", "(+ 5 6)"};
+  std::vector<SourceBuffer> sources;
+  for(auto & p : programs){
+    sources.emplace_back(p);
+  }
+
+  AstCache unbounded(directory);
+  for(auto & s : sources){
+    std::remove(unbounded.entryPath(s).c_str());
+  }
+  unbounded.store(sources[0], parsed(programs[0]));
+  unbounded.store(sources[1], parsed(programs[1]));
+
+  // room for any two of the entries, which are all the same size
+  std::uint64_t entry = file_size(unbounded.entryPath(sources[0]));
+  REQUIRE(entry > 0);
+  AstCache two(directory, 2 * entry + entry / 2);
+
+  {
+    INFO("storing over the capacity removes the oldest entry");
+    set_used(two.entryPath(sources[0]), 1000);
+    set_used(two.entryPath(sources[1]), 2000);
+    two.store(sources[2], parsed(programs[2]));
+    REQUIRE(!exists(two.entryPath(sources[0])));
+    REQUIRE(exists(two.entryPath(sources[1])));
+    REQUIRE(exists(two.entryPath(sources[2])));
+  }
+
+  {
+    INFO("a hit makes an entry the most recently used");
+    set_used(two.entryPath(sources[1]), 1000);
+    set_used(two.entryPath(sources[2]), 2000);
+    Expression ast;
+    REQUIRE(two.load(sources[1], ast));
+    two.store(sources[0], parsed(programs[0]));
+    REQUIRE(exists(two.entryPath(sources[0])));
+    REQUIRE(exists(two.entryPath(sources[1])));
+    REQUIRE(!exists(two.entryPath(sources[2])));
+  }
+
+  for(auto & s : sources){
+    std::remove(two.entryPath(s).c_str());
+  }
+  std::remove(directory.c_str());
+}
+#endif
@@ -1,9 +1,35 @@
 #include "atom.hpp"
 
-#include <sstream>
 #include <cctype>
 #include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
 #include <limits>
+#include <mutex>
+#include <unordered_map>
+
+const InternedSymbol * intern(const std::string & name){
+
+  // entries live in a deque so pointers to them stay valid as it grows
+  static std::mutex table_mutex;
+  static std::deque<InternedSymbol> entries;
+  static std::unordered_map<std::string, const InternedSymbol *> index;
+
+  std::lock_guard<std::mutex> lock(table_mutex);
+
+  auto found = index.find(name);
+  if(found != index.end()){
+    return found->second;
+  }
+
+  entries.push_back(InternedSymbol{name, entries.size()});
+  const InternedSymbol * entry = &entries.back();
+  index.emplace(name, entry);
+
+  return entry;
+}
 
 Atom::Atom(): m_type(NoneKind) {}
 
@@ -12,89 +38,156 @@ Atom::Atom(double value){
   setNumber(value);
 }
 
-Atom::Atom(const Token & token): Atom(){
-  
-  // is token a number?
-  double temp;
-  std::istringstream iss(token.asString());
-  if(iss >> temp){
-    // check for trailing characters if >> succeeds
-    if(iss.rdbuf()->in_avail() == 0){
-      setNumber(temp);
+// how a token reads as a number, see scan_number
+enum NumberScan { NotNumber,    ///< no number at the start
+		  WholeNumber,  ///< the token is a number
+		  NumberPrefix  ///< a number followed by other characters
+};
+
+// powers of ten exactly representable as a double
+static const double EXACT_POWERS[] = {
+  1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+  1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+// Read a number from the start of text as std::istream >> double does: the
+// longest prefix of the form [+-]digits[.digits][(e|E)[+-]digits] is
+// converted, and fails if it has no digits, an incomplete exponent, or
+// overflows. Most literals are converted exactly in one pass, the rest by
+// strtod, and neither allocates.
+static NumberScan scan_number(const char * text, std::size_t length, double & value){
+
+  std::size_t i = 0;
+  while(i < length && std::isspace(static_cast<unsigned char>(text[i]))) i += 1;
+  std::size_t begin = i;
+
+  if(i < length && (text[i] == '+' || text[i] == '-')) i += 1;
+  bool negative = (i > begin && text[begin] == '-');
+
+  // the leading significant digits, and the power of ten they are scaled by
+  const std::uint64_t MAX_MANTISSA = 1000000000000000000ULL;
+  std::uint64_t mantissa = 0;
+  long exponent = 0;
+  bool truncated = false;
+  bool digits = false;
+  bool point = false;
+
+  for(; i < length; ++i){
+    char c = text[i];
+    if(c >= '0' && c <= '9'){
+      digits = true;
+      if(mantissa < MAX_MANTISSA){
+	mantissa = mantissa * 10 + (c - '0');
+	if(point) exponent -= 1;
+      }
+      else{
+	truncated = truncated || (c != '0');
+	if(!point) exponent += 1;
+      }
     }
-  }
-  else{ // else assume symbol
-    // make sure does not start with number
-    if(!std::isdigit(token.asString()[0])){
-      setSymbol(token.asString());
+    else if(c == '.' && !point){
+      point = true;
+    }
+    else{
+      break;
     }
   }
-}
 
-Atom::Atom(const std::string & value): Atom() {
-  
-  setSymbol(value);
-}
+  // an exponent is only read after mantissa digits, and must have digits
+  bool valid = digits;
+  if(digits && i < length && (text[i] == 'e' || text[i] == 'E')){
+    i += 1;
+    bool exp_negative = false;
+    if(i < length && (text[i] == '+' || text[i] == '-')){
+      exp_negative = (text[i] == '-');
+      i += 1;
+    }
+    long power = 0;
+    valid = false;
+    for(; i < length && text[i] >= '0' && text[i] <= '9'; ++i){
+      valid = true;
+      if(power < 100000) power = power * 10 + (text[i] - '0');
+    }
+    exponent += exp_negative ? -power : power;
+  }
 
-Atom::Atom(const std::complex<double> value): Atom()
-{
-	setComplex(value);
-}
+  if(!valid){
+    return NotNumber;
+  }
 
-Atom::Atom(const Atom & x): Atom(){
-  if(x.isNumber()){
-    setNumber(x.numberValue);
+  if(!truncated && mantissa <= (1ULL << 53) && exponent >= -22 && exponent <= 22){
+    // both the mantissa and the power are exact, so one rounding gives the
+    // correctly rounded result
+    double m = static_cast<double>(mantissa);
+    value = (exponent < 0) ? m / EXACT_POWERS[-exponent] : m * EXACT_POWERS[exponent];
+    if(negative) value = -value;
   }
-  else if(x.isSymbol()){
-    setSymbol(x.stringValue);
+  else{
+    char buffer[64];
+    std::size_t n = i - begin;
+    if(n < sizeof(buffer)){
+      std::memcpy(buffer, text + begin, n);
+      buffer[n] = '\0';
+      value = std::strtod(buffer, nullptr);
+    }
+    else{
+      value = std::strtod(std::string(text + begin, n).c_str(), nullptr);
+    }
+  }
+
+  if(std::isinf(value)){
+    return NotNumber;
   }
+
+  return (i == length) ? WholeNumber : NumberPrefix;
 }
 
-Atom & Atom::operator=(const Atom & x){
+Atom::Atom(const Token & token): Atom(){
 
-  if(this != &x){
-    if(x.m_type == NoneKind){
-      m_type = NoneKind;
-    }
-    else if(x.m_type == NumberKind){
-      setNumber(x.numberValue);
-    }
-    else if(x.m_type == SymbolKind){
-      setSymbol(x.stringValue);
+  std::string text = token.asString();
+  *this = Atom(text.data(), text.size());
+}
+
+Atom::Atom(const char * text, std::size_t length): Atom(){
+
+  // is token a number?
+  double temp;
+  switch(scan_number(text, length, temp)){
+  case WholeNumber:
+    setNumber(temp);
+    break;
+  case NumberPrefix:
+    // trailing characters, neither a number nor a symbol
+    break;
+  case NotNumber:
+    // else assume symbol, make sure does not start with number
+    if(length == 0 || !std::isdigit(static_cast<unsigned char>(text[0]))){
+      setSymbol(std::string(text, length));
     }
-	else if (x.m_type == ComplexKind) {
-		setComplex(x.complexValue);
-	}
+    break;
   }
-  return *this;
 }
+
+Atom::Atom(const std::string & value): Atom() {
   
-Atom::~Atom(){
+  setSymbol(value);
+}
 
-  // we need to ensure the destructor of the symbol string is called
-  if(m_type == SymbolKind){
-    stringValue.~basic_string();
-  }
+Atom::Atom(const std::complex<double> value): Atom()
+{
+	setComplex(value);
 }
 
 bool Atom::isNone() const noexcept{
   return m_type == NoneKind;
 }
 
-bool Atom::isNumber() const noexcept{
-  return m_type == NumberKind;
-}
-
 bool Atom::isSymbol() const noexcept{
   return m_type == SymbolKind;
 }
 
 
 
-bool Atom::isComplex() const noexcept{
-	return m_type == ComplexKind;
-}
-
 
 
 void Atom::setNumber(double value){
@@ -105,21 +198,15 @@ void Atom::setNumber(double value){
 
 void Atom::setSymbol(const std::string & value){
 
-  // we need to ensure the destructor of the symbol string is called
-  if(m_type == SymbolKind){
-    stringValue.~basic_string();
-  }
-    
   m_type = SymbolKind;
-
-  // copy construct in place
-  new (&stringValue) std::string(value);
+  symbolValue = intern(value);
 }
 
 void Atom::setComplex(const std::complex<double> value)
 {
 	m_type = ComplexKind;
-	complexValue = value;
+	complexValue[0] = value.real();
+	complexValue[1] = value.imag();
 
 }
 
@@ -128,28 +215,24 @@ std::complex<double> Atom::asComplex() const noexcept
 	std::complex<double> result;
 
 	if (m_type == ComplexKind) {
-		result = complexValue;
+		result = std::complex<double>(complexValue[0], complexValue[1]);
 	}
 
 	return result;
 }
 
 
-double Atom::asNumber() const noexcept{
 
-  return (m_type == NumberKind) ? numberValue : 0.0;  
-}
+const std::string & Atom::asSymbol() const noexcept{
 
+  static const std::string empty;
 
-std::string Atom::asSymbol() const noexcept{
-
-  std::string result;
+  return (m_type == SymbolKind) ? symbolValue->name : empty;
+}
 
-  if(m_type == SymbolKind){
-    result = stringValue;
-  }
+std::size_t Atom::symbolId() const noexcept{
 
-  return result;
+  return (m_type == SymbolKind) ? symbolValue->id : 0;
 }
 
 bool Atom::operator==(const Atom & right) const noexcept{
@@ -174,14 +257,16 @@ bool Atom::operator==(const Atom & right) const noexcept{
     {
       if(right.m_type != SymbolKind) return false;
 
-      return stringValue == right.stringValue;
+      // interned, so equal names share an entry
+      return symbolValue == right.symbolValue;
     }
     break;
   case ComplexKind:
   {
 	  if (right.m_type != ComplexKind) return false;
 
-	  return complexValue == right.complexValue;
+	  return (complexValue[0] == right.complexValue[0]) &&
+		  (complexValue[1] == right.complexValue[1]);
   }
   break;
   default:
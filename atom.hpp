@@ -6,11 +6,39 @@ Defines the Atom type and associated functions.
 
 #include "token.hpp"
 #include <complex>
+#include <cstddef>
+#include <string>
+#include <type_traits>
+
+/*! \struct InternedSymbol
+\brief The single process-wide copy of a symbol name.
+
+Every Atom of type Symbol with the same name refers to the same
+InternedSymbol, so symbols compare by address. Entries are never freed and
+never move, and ids are dense, starting from zero.
+*/
+struct InternedSymbol {
+  /// the symbol name
+  std::string name;
+
+  /// the dense id of the symbol
+  std::size_t id;
+};
+
+/*! \fn intern
+\brief Return the unique entry for a symbol name, creating it if needed.
+
+This is safe to call concurrently from multiple threads.
+*/
+const InternedSymbol * intern(const std::string & name);
 
 /*! \class Atom
 \brief A variant type that may be a Number or Symbol or the default type None.
 
-This class provides value semantics.
+This class provides value semantics. An Atom is a tag and an inline payload:
+a number, the real and imaginary parts of a complex, or a handle to an
+interned symbol. It owns nothing, so it is trivially copyable and a list of
+atoms can be copied as plain memory.
 */
 class Atom {
 public:
@@ -30,14 +58,25 @@ public:
   /// Construct an Atom directly from a Token
   Atom(const Token & token);
 
+  /*! Construct an Atom from the characters of a token, e.g. a TokenView: a
+    Number if they are one, None if they start with a number, else a Symbol
+   */
+  Atom(const char * text, std::size_t length);
+
   /// Copy-construct an Atom
-  Atom(const Atom & x);
+  Atom(const Atom & x) = default;
 
   /// Assign an Atom
-  Atom & operator=(const Atom & x);
+  Atom & operator=(const Atom & x) = default;
+
+  /// Move-construct an Atom, an Atom owns no resources so this copies
+  Atom(Atom && x) noexcept = default;
+
+  /// Move-assign an Atom, an Atom owns no resources so this copies
+  Atom & operator=(Atom && x) noexcept = default;
 
   /// Atom destructor
-  ~Atom();
+  ~Atom() = default;
 
   /// predicate to determine if an Atom is of type None
   bool isNone() const noexcept;
@@ -61,8 +100,11 @@ public:
   /// value of Atom as a number, return 0 if not a Number
   double asNumber() const noexcept;
 
-  /// value of Atom as a number, returns empty-string if not a Symbol
-  std::string asSymbol() const noexcept;
+  /// value of Atom as a symbol, returns empty-string if not a Symbol
+  const std::string & asSymbol() const noexcept;
+
+  /// interned id of the Symbol, only meaningful if isSymbol()
+  std::size_t symbolId() const noexcept;
 
   std::string asLambda() const noexcept;
 
@@ -73,17 +115,18 @@ public:
 private:
 
   // internal enum of known types
-  enum Type {NoneKind, NumberKind, SymbolKind, ComplexKind, LambdaKind};
+  enum Type : unsigned char {NoneKind, NumberKind, SymbolKind, ComplexKind, LambdaKind};
 
   // track the type
   Type m_type;
 
-  // values for the known types. Note the use of a union requires care
-  // when setting non POD values (see setSymbol)
+  // values for the known types. Symbols are stored as a pointer to
+  // their interned name, complex values as their real and imaginary parts
+  // so every member is trivial.
   union {
-	  std::complex<double> complexValue;
+    double complexValue[2];
     double numberValue;
-    std::string stringValue;
+    const InternedSymbol * symbolValue;
   };
 
   /// helper to set type and value of Number
@@ -102,4 +145,23 @@ bool operator!=(const Atom &left, const Atom & right) noexcept;
 /// output stream rendering
 std::ostream & operator<<(std::ostream & out, const Atom & a);
 
+// the type tests and the number accessor are inline, the arithmetic
+// builtins run them in their inner loops
+inline bool Atom::isNumber() const noexcept{
+  return m_type == NumberKind;
+}
+
+inline bool Atom::isComplex() const noexcept{
+  return m_type == ComplexKind;
+}
+
+inline double Atom::asNumber() const noexcept{
+  return (m_type == NumberKind) ? numberValue : 0.0;
+}
+
+static_assert(std::is_trivially_copyable<Atom>::value,
+	      "Atom is copied as plain memory");
+static_assert(sizeof(Atom) <= 3 * sizeof(double),
+	      "Atom holds at most a tag and a complex");
+
 #endif
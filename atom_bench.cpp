@@ -0,0 +1,91 @@
+// Compares classifying tokens as numbers or symbols through a
+// std::istringstream, as Atom(const Token &) used to, with the Atom
+// constructor over the token characters, for 10^6 tokens.
+//
+// usage: atom_bench [tokens]
+
+#include <cctype>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "atom.hpp"
+
+// the classification through a stream
+static Atom stream_atom(const std::string & text){
+
+  Atom atom;
+  double temp;
+  std::istringstream iss(text);
+  if(iss >> temp){
+    if(iss.rdbuf()->in_avail() == 0){
+      atom = Atom(temp);
+    }
+  }
+  else if(!std::isdigit(static_cast<unsigned char>(text[0]))){
+    atom = Atom(text);
+  }
+  return atom;
+}
+
+// the best of a few runs in millions of tokens per second
+template <typename F>
+static double throughput(std::size_t n, F run){
+
+  double best = 0;
+  for(int i = 0; i < 3; ++i){
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double rate = n / elapsed.count() / 1e6;
+    if(rate > best) best = rate;
+  }
+  return best;
+}
+
+int main(int argc, char * argv[]){
+
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 1000000;
+
+  // the mix of a generated script: integers, decimals, exponents and symbols
+  const char * symbols[] = {"define", "begin", "list", "+", "*", "x", "lambda", "point"};
+  std::string text;
+  std::vector<std::size_t> offsets;
+  char buffer[32];
+  for(std::size_t i = 0; i < n; ++i){
+    switch(i % 4){
+    case 0: std::snprintf(buffer, sizeof(buffer), "%zu", i); break;
+    case 1: std::snprintf(buffer, sizeof(buffer), "%.6f", i / 7.0); break;
+    case 2: std::snprintf(buffer, sizeof(buffer), "%.3e", i * 1.5e3); break;
+    default: std::snprintf(buffer, sizeof(buffer), "%s", symbols[i % 8]); break;
+    }
+    offsets.push_back(text.size());
+    text += buffer;
+  }
+  offsets.push_back(text.size());
+
+  std::vector<std::string> tokens;
+  for(std::size_t i = 0; i < n; ++i){
+    tokens.emplace_back(text, offsets[i], offsets[i + 1] - offsets[i]);
+  }
+
+  std::size_t numbers = 0;
+  double stream_rate = throughput(n, [&](){
+      for(const std::string & token : tokens) numbers += stream_atom(token).isNumber();
+    });
+  double scan_rate = throughput(n, [&](){
+      for(std::size_t i = 0; i < n; ++i){
+	numbers += Atom(text.data() + offsets[i], offsets[i + 1] - offsets[i]).isNumber();
+      }
+    });
+
+  std::printf("%zu tokens, Mtokens/s\n", n);
+  std::printf("%-12s %10.1f\n", "istringstream", stream_rate);
+  std::printf("%-12s %10.1f\n", "scan", scan_rate);
+  std::printf("speedup      %10.1fx\n", scan_rate / stream_rate);
+
+  return numbers == 0;
+}
@@ -1,5 +1,7 @@
 #include "catch.hpp"
 
+#include <cmath>
+
 #include "atom.hpp"
 
 TEST_CASE( "Test constructors", "[atom]" ) {
@@ -221,3 +223,84 @@ TEST_CASE( "test comparison", "[atom]" ) {
 
 
 
+TEST_CASE( "Test symbol interning", "[atom]" ) {
+
+  Atom a("interned");
+  Atom b(std::string("intern") + "ed");
+  Atom c("other");
+
+  REQUIRE(a.symbolId() == b.symbolId());
+  REQUIRE(a.symbolId() != c.symbolId());
+  REQUIRE(&a.asSymbol() == &b.asSymbol());
+  REQUIRE(a.asSymbol() == "interned");
+
+  REQUIRE(intern("interned") == intern("interned"));
+  REQUIRE(intern("interned")->id == a.symbolId());
+
+  Atom n(1.0);
+  REQUIRE(n.asSymbol().empty());
+}
+
+TEST_CASE( "Test atoms from token characters", "[atom]" ) {
+
+  auto from = [](const std::string & text){ return Atom(text.data(), text.size()); };
+
+  {
+    INFO("Numbers");
+    REQUIRE(from("1") == Atom(1.0));
+    REQUIRE(from("-2.5") == Atom(-2.5));
+    REQUIRE(from("+.5") == Atom(0.5));
+    REQUIRE(from("5.") == Atom(5.0));
+    REQUIRE(from("1e3") == Atom(1000.0));
+    REQUIRE(from("1.E-3") == Atom(0.001));
+    REQUIRE(from("0.1").asNumber() == 0.1);
+    REQUIRE(from("3.141592653589793238").asNumber() == 3.141592653589793);
+    REQUIRE(from("123456789012345678901234567890").asNumber() == 1.2345678901234568e29);
+    REQUIRE(from("4.9e-324").asNumber() == 4.9e-324);
+    REQUIRE(from("1e-400").asNumber() == 0);
+    REQUIRE(std::signbit(from("-0").asNumber()));
+  }
+
+  {
+    INFO("Symbols");
+    REQUIRE(from("abc") == Atom("abc"));
+    REQUIRE(from("-") == Atom("-"));
+    REQUIRE(from("+") == Atom("+"));
+    REQUIRE(from(".") == Atom("."));
+    REQUIRE(from("e5") == Atom("e5"));
+    REQUIRE(from("-1e") == Atom("-1e"));
+    REQUIRE(from("-1e999") == Atom("-1e999"));
+    REQUIRE(from("\"text\"") == Atom("\"text\""));
+  }
+
+  {
+    INFO("Neither");
+    REQUIRE(from("1.2abc").isNone());
+    REQUIRE(from("1e").isNone());
+    REQUIRE(from("1e999").isNone());
+    REQUIRE(from("1.2.3").isNone());
+    REQUIRE(from("-1x").isNone());
+  }
+
+  REQUIRE(Atom(Token("2.5e1")) == from("25"));
+}
+
+TEST_CASE( "Test complex atoms", "[atom]" ) {
+
+  Atom a(std::complex<double>(1.5, -2.0));
+  REQUIRE(a.isComplex());
+  REQUIRE(!a.isNumber());
+  REQUIRE(a.asComplex() == std::complex<double>(1.5, -2.0));
+  REQUIRE(a.asNumber() == 0.0);
+
+  Atom b(a);
+  REQUIRE(b == a);
+
+  Atom c(1.0);
+  c = a;
+  REQUIRE(c == a);
+  REQUIRE(c != Atom(std::complex<double>(1.5, 2.0)));
+  REQUIRE(c != Atom(1.5));
+
+  REQUIRE(Atom(3.0).asComplex() == std::complex<double>());
+}
@@ -0,0 +1,428 @@
+#include "bytecode.hpp"
+
+// system includes
+#include <algorithm>
+#include <iterator>
+#include <utility>
+
+// module includes
+#include "semantic_error.hpp"
+
+// compiled lambda bodies kept before the cache is flushed
+const std::size_t MAX_CACHED_LAMBDAS = 256;
+
+/***********************************************************************
+Compiler
+**********************************************************************/
+
+static std::size_t add_constant(Chunk & chunk, const Expression & exp){
+  chunk.constants.push_back(exp);
+  return chunk.constants.size() - 1;
+}
+
+static void emit(Chunk & chunk, OpCode op, std::size_t arg = 0, std::size_t count = 0){
+  chunk.code.push_back(Instruction{op, arg, count});
+}
+
+static bool is_empty(const Expression & exp){
+  return exp.tailConstBegin() == exp.tailConstEnd();
+}
+
+// predicate, the atom is a symbol that names something rather than a string
+static bool is_name(const Atom & a){
+  return a.isSymbol() && !a.asSymbol().empty() && (a.asSymbol()[0] != '"');
+}
+
+// find the parameter slot of a symbol, if it is a parameter
+static bool find_slot(const std::vector<Atom> & params, const Atom & sym, std::size_t & slot){
+  for(std::size_t i = 0; i < params.size(); ++i){
+    if(params[i] == sym){
+      slot = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+// predicate, a define appears anywhere in the expression
+static bool contains_define(const Expression & exp){
+  if(exp.form() == Expression::DefineForm) return true;
+
+  for(auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e){
+    if(contains_define(*e)) return true;
+  }
+  return false;
+}
+
+// compile exp, tail is true when its value is returned by the enclosing
+// lambda body as is
+static void compile_node(const Expression & exp, Chunk & chunk,
+                         const std::vector<Atom> & params, bool tail,
+                         const Environment & env){
+
+  const Atom & head = exp.head();
+  Expression::Form form = exp.form();
+  std::size_t nargs = exp.tailConstEnd() - exp.tailConstBegin();
+  std::size_t slot = 0;
+
+  // anything not handled below is left to the tree walker
+  bool handled = true;
+
+  if(form == Expression::ApplyForm){
+    handled = false;
+  }
+  else if(is_empty(exp) && (form != Expression::ListForm)){
+    if(is_name(head)){
+      if(find_slot(params, head, slot)){
+        emit(chunk, LoadLocal, slot);
+      }
+      else{
+        emit(chunk, LoadGlobal, add_constant(chunk, Expression(head)));
+      }
+    }
+    else if(head.isNumber() || head.isComplex() || head.isSymbol()){
+      emit(chunk, PushConst, add_constant(chunk, Expression(head)));
+    }
+    else{
+      handled = false;
+    }
+  }
+  else if(form == Expression::BeginForm){
+    for(auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e){
+      if(e != exp.tailConstBegin()){
+        emit(chunk, Pop);
+      }
+      compile_node(*e, chunk, params, tail && (e + 1 == exp.tailConstEnd()), env);
+    }
+  }
+  else if(form == Expression::DefineForm){
+    // only well-formed definitions, the tree walker reports the errors
+    const Expression & name = *exp.tailConstBegin();
+    handled = (nargs == 2) && is_empty(name) && name.isHeadSymbol() &&
+      (name.form() != Expression::DefineForm) && (name.form() != Expression::BeginForm) &&
+      (name.form() != Expression::SetPropertyForm) && !env.is_proc(name.head());
+    if(handled){
+      compile_node(*(exp.tailConstBegin() + 1), chunk, params, false, env);
+      emit(chunk, Define, add_constant(chunk, name));
+    }
+  }
+  else if((form == Expression::NoForm) || (form == Expression::ListForm)){
+    handled = is_name(head) && !find_slot(params, head, slot);
+    if(handled){
+      for(auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e){
+        compile_node(*e, chunk, params, false, env);
+      }
+      // no frame can rebind a built-in, handle_lambda rejects such
+      // parameters, so binding the procedure at compile time is safe
+      if(env.is_proc(head)){
+        chunk.procs.push_back(env.get_proc(head));
+        emit(chunk, CallBuiltin, chunk.procs.size() - 1, nargs);
+      }
+      else{
+        emit(chunk, tail ? TailCall : CallClosure, add_constant(chunk, Expression(head)), nargs);
+      }
+    }
+  }
+  else{
+    handled = false;
+  }
+
+  if(!handled){
+    emit(chunk, EvalTree, add_constant(chunk, exp));
+  }
+}
+
+Chunk compile(const Expression & exp, const Environment & env){
+
+  Chunk chunk;
+  std::vector<Atom> params;
+
+  compile_node(exp, chunk, params, false, env);
+  emit(chunk, Return);
+
+  return chunk;
+}
+
+// compile a lambda body with its parameters as slots, false if the lambda
+// must be left to the tree walker
+static bool compile_lambda(const Expression & lambda, const Environment & env,
+                           std::vector<Atom> & params, Chunk & body){
+
+  const Expression & list = *lambda.tailConstBegin();
+  const Expression & exp = *(lambda.tailConstBegin() + 1);
+
+  // calls to a memoized lambda go through its memo table
+  if(lambda.memo() != nullptr) return false;
+
+  for(auto p = list.tailConstBegin(); p != list.tailConstEnd(); ++p){
+    if(!p->isHeadSymbol() || !is_empty(*p)) return false;
+    params.push_back(p->head());
+  }
+
+  compile_node(exp, body, params, true, env);
+  emit(body, Return);
+
+  // a definition inside a subtree left to the tree walker would be made in
+  // a scratch frame and lost
+  for(auto & in : body.code){
+    if((in.op == EvalTree) && contains_define(body.constants[in.arg])) return false;
+  }
+
+  return true;
+}
+
+/***********************************************************************
+Virtual Machine
+**********************************************************************/
+
+VirtualMachine::VirtualMachine(): max_depth(0){}
+
+Expression VirtualMachine::run(const Chunk & program, Environment & env){
+
+  stack.clear();
+  frames.clear();
+  max_depth = 0;
+
+  // nothing refers into the cache between runs
+  if(lambdas.size() > MAX_CACHED_LAMBDAS){
+    lambdas.clear();
+  }
+
+  const Chunk * chunk = &program;
+  std::size_t ip = 0;
+  std::size_t base = 0;
+
+  while(true){
+    const Instruction & in = chunk->code[ip++];
+
+    switch(in.op){
+    case PushConst:
+      stack.push_back(chunk->constants[in.arg]);
+      break;
+    case LoadLocal:
+      {
+        Expression value = stack[base + in.arg];
+        stack.push_back(std::move(value));
+      }
+      break;
+    case LoadGlobal:
+      stack.push_back(load(chunk->constants[in.arg].head(), env));
+      break;
+    case Define:
+      if(frames.empty()){
+        env.add_exp(chunk->constants[in.arg].head(), stack.back());
+      }
+      else{
+        define(chunk->constants[in.arg].head(), stack.back());
+      }
+      break;
+    case Pop:
+      stack.pop_back();
+      break;
+    case CallBuiltin:
+      {
+        std::vector<Expression> args(std::make_move_iterator(stack.end() - in.count),
+                                     std::make_move_iterator(stack.end()));
+        stack.resize(stack.size() - in.count);
+        stack.push_back(chunk->procs[in.arg](args));
+      }
+      break;
+    case CallClosure:
+    case TailCall:
+      {
+        const Atom & name = chunk->constants[in.arg].head();
+
+        // bindings of active calls shadow the environment
+        Expression shadowed;
+        bool is_local = find(name, shadowed);
+
+        std::uint64_t stamp = 0;
+        const Expression * lambda = is_local ? &shadowed : env.find_exp(name, stamp);
+        if((lambda == nullptr) || (lambda->form() != Expression::LambdaForm)){
+          throw SemanticError("Error during evaluation: symbol does not name a procedure");
+        }
+
+        const Expression & list = *lambda->tailConstBegin();
+        if(in.count != static_cast<std::size_t>(list.tailConstEnd() - list.tailConstBegin())){
+          throw SemanticError("Error in call to lambda: incorrect number of arguments");
+        }
+
+        const CompiledLambda * fn = is_local ? nullptr : compiled(*lambda, stamp, env);
+        if(fn == nullptr){
+          std::vector<Expression> args(std::make_move_iterator(stack.end() - in.count),
+                                       std::make_move_iterator(stack.end()));
+          stack.resize(stack.size() - in.count);
+          stack.push_back(callTree(*lambda, args, env));
+        }
+        else if((in.op == TailCall) && !frames.empty()){
+          replace(fn, in.count);
+          chunk = &fn->body;
+          ip = 0;
+        }
+        else{
+          base = stack.size() - in.count;
+          frames.push_back(Frame{fn, chunk, ip, base, Bindings()});
+          max_depth = std::max(max_depth, frames.size());
+          chunk = &fn->body;
+          ip = 0;
+        }
+      }
+      break;
+    case EvalTree:
+      stack.push_back(evalTree(chunk->constants[in.arg], env));
+      break;
+    case Return:
+      {
+        if(frames.empty()){
+          return stack.back();
+        }
+
+        Expression result = std::move(stack.back());
+        Frame & frame = frames.back();
+
+        stack.resize(frame.base);
+        stack.push_back(std::move(result));
+
+        chunk = frame.chunk;
+        ip = frame.ip;
+        frames.pop_back();
+        base = frames.empty() ? 0 : frames.back().base;
+      }
+      break;
+    }
+  }
+}
+
+std::size_t VirtualMachine::maxDepth() const noexcept{
+
+  return max_depth;
+}
+
+bool VirtualMachine::find(const Atom & sym, Expression & value) const{
+
+  for(auto f = frames.rbegin(); f != frames.rend(); ++f){
+    std::size_t slot = 0;
+    if(find_slot(f->lambda->params, sym, slot)){
+      value = stack[f->base + slot];
+      return true;
+    }
+    for(auto & b : f->bindings){
+      if(b.first == sym){
+        value = b.second;
+        return true;
+      }
+    }
+  }
+  return false;
+}
+
+void VirtualMachine::define(const Atom & sym, const Expression & value){
+
+  Frame & top = frames.back();
+
+  std::size_t slot = 0;
+  if(find_slot(top.lambda->params, sym, slot)){
+    stack[top.base + slot] = value;
+    return;
+  }
+  for(auto & b : top.bindings){
+    if(b.first == sym){
+      b.second = value;
+      return;
+    }
+  }
+  top.bindings.emplace_back(sym, value);
+}
+
+void VirtualMachine::replace(const CompiledLambda * fn, std::size_t count){
+
+  Frame & top = frames.back();
+
+  // under dynamic scoping the callee still sees the bindings of the call it
+  // replaces, keep those it does not shadow
+  Bindings kept;
+  std::size_t slot = 0;
+  for(std::size_t i = 0; i < top.lambda->params.size(); ++i){
+    const Atom & name = top.lambda->params[i];
+    if(!find_slot(fn->params, name, slot)){
+      kept.emplace_back(name, stack[top.base + i]);
+    }
+  }
+  for(auto & b : top.bindings){
+    if(!find_slot(fn->params, b.first, slot)){
+      kept.emplace_back(b);
+    }
+  }
+
+  // the arguments take over the parameter slots of the finished call
+  std::size_t first = stack.size() - count;
+  for(std::size_t i = 0; i < count; ++i){
+    stack[top.base + i] = std::move(stack[first + i]);
+  }
+  stack.resize(top.base + count);
+
+  top.lambda = fn;
+  top.bindings.swap(kept);
+}
+
+Expression VirtualMachine::load(const Atom & sym, Environment & env) const{
+
+  Expression value;
+  if(find(sym, value)){
+    return value;
+  }
+
+  if(!env.is_exp(sym)){
+    throw SemanticError("Error during evaluation: unknown symbol");
+  }
+  return env.get_exp(sym);
+}
+
+Environment * VirtualMachine::scope(std::deque<Environment> & scopes, Environment & env) const{
+
+  // rebuild the active calls as a chain of local frames, innermost last
+  Environment * scope = &env;
+  for(auto & f : frames){
+    scopes.emplace_back(scope);
+    for(auto & b : f.bindings){
+      scopes.back().add_exp(b.first, b.second);
+    }
+    for(std::size_t slot = 0; slot < f.lambda->params.size(); ++slot){
+      scopes.back().add_exp(f.lambda->params[slot], stack[f.base + slot]);
+    }
+    scope = &scopes.back();
+  }
+  return scope;
+}
+
+Expression VirtualMachine::evalTree(const Expression & exp, Environment & env) const{
+
+  std::deque<Environment> scopes;
+  Environment * innermost = scope(scopes, env);
+
+  return exp.eval(*innermost);
+}
+
+Expression VirtualMachine::callTree(const Expression & lambda, std::vector<Expression> & args,
+                                    Environment & env) const{
+
+  std::deque<Environment> scopes;
+  return lambda.call(*scope(scopes, env), args);
+}
+
+const VirtualMachine::CompiledLambda * VirtualMachine::compiled(const Expression & lambda,
+                                                                std::uint64_t stamp,
+                                                                const Environment & env){
+
+  auto found = lambdas.find(stamp);
+  if(found == lambdas.end()){
+    CompiledLambda fn;
+    if(!compile_lambda(lambda, env, fn.params, fn.body)){
+      // remember the failure, an empty body is never valid
+      fn.body.code.clear();
+    }
+    found = lambdas.emplace(stamp, fn).first;
+  }
+
+  return found->second.body.code.empty() ? nullptr : &found->second;
+}
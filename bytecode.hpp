@@ -0,0 +1,151 @@
+/*! \file bytecode.hpp
+Defines the bytecode compiler and the stack virtual machine that runs it.
+
+The compiler turns an Expression AST into a flat Chunk of instructions.
+Literals, symbol lookups, calls to built-in procedures, calls to lambdas,
+begin and define are compiled directly. Every other special form
+is embedded as a subtree the virtual machine hands back to the tree walker
+in Expression::eval, so both engines always agree on semantics.
+ */
+#ifndef BYTECODE_HPP
+#define BYTECODE_HPP
+
+// system includes
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// module includes
+#include "atom.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \enum OpCode
+\brief The instructions understood by the VirtualMachine.
+ */
+enum OpCode {
+  PushConst,   ///< push constants[arg]
+  LoadLocal,   ///< push parameter slot arg of the running lambda
+  LoadGlobal,  ///< push the value of the symbol in constants[arg]
+  Define,      ///< bind the symbol in constants[arg] to the top of stack
+  Pop,         ///< discard the top of stack
+  CallBuiltin, ///< call procs[arg] with the top count values
+  CallClosure, ///< call the lambda named by constants[arg] with the top count values
+  TailCall,    ///< as CallClosure, replacing the frame of the running lambda
+  EvalTree,    ///< push the tree-walking evaluation of constants[arg]
+  Return       ///< return the top of stack to the caller
+};
+
+/*! \struct Instruction
+\brief A single VirtualMachine instruction with its operands.
+ */
+struct Instruction {
+  OpCode op;
+  std::size_t arg;
+  std::size_t count;
+};
+
+/*! \struct Chunk
+\brief A compiled program or lambda body.
+ */
+struct Chunk {
+  /// the instruction sequence, always ending in Return
+  std::vector<Instruction> code;
+
+  /// literal values, symbol names and embedded subtrees
+  std::vector<Expression> constants;
+
+  /// built-in procedures resolved at compile time
+  std::vector<Procedure> procs;
+};
+
+/*! \fn compile
+\brief compile an expression into a chunk for top-level execution
+
+\param exp the expression to compile
+\param env the environment used to resolve built-in procedures
+\return the compiled chunk
+ */
+Chunk compile(const Expression & exp, const Environment & env);
+
+/*! \class VirtualMachine
+\brief A stack machine executing compiled Chunks.
+
+Lambda calls push a frame on a heap-allocated call stack rather than
+recursing, and lambda bodies are compiled on first call and cached by the
+definition stamp of the symbol naming them. Lambda parameters live in stack
+slots; as in the tree walker, a lambda sees the parameters of its callers.
+
+A call in tail position of a lambda body, including the last expression of
+a begin, reuses the frame of the running lambda, so tail recursion runs in
+constant space.
+ */
+class VirtualMachine {
+public:
+
+  /// Construct a machine with an empty call stack
+  VirtualMachine();
+
+  /*! Run a compiled program
+    \param program the chunk to run
+    \param env the environment to evaluate in
+    \return the value of the program
+    \throws SemanticError when a semantic error is encountered
+   */
+  Expression run(const Chunk & program, Environment & env);
+
+  /// the most lambda frames active at once during the last run
+  std::size_t maxDepth() const noexcept;
+
+private:
+
+  // a lambda body compiled with its parameters as local slots
+  struct CompiledLambda {
+    std::vector<Atom> params;
+    Chunk body;
+  };
+
+  // bindings of a frame that have no parameter slot
+  typedef std::vector<std::pair<Atom, Expression> > Bindings;
+
+  // an active lambda call
+  struct Frame {
+    const CompiledLambda * lambda;
+    const Chunk * chunk;
+    std::size_t ip;
+    std::size_t base;
+
+    // definitions made by the body, and the bindings of calls this frame
+    // replaced by a tail call
+    Bindings bindings;
+  };
+
+  // the operand stack, parameters of active calls included
+  std::vector<Expression> stack;
+
+  // the call stack
+  std::vector<Frame> frames;
+
+  // see maxDepth()
+  std::size_t max_depth;
+
+  // compiled lambda bodies keyed by definition stamp
+  std::unordered_map<std::uint64_t, CompiledLambda> lambdas;
+
+  // helpers for the instructions that need the dynamic scope
+  Environment * scope(std::deque<Environment> & scopes, Environment & env) const;
+  bool find(const Atom & sym, Expression & value) const;
+  void define(const Atom & sym, const Expression & value);
+  void replace(const CompiledLambda * fn, std::size_t count);
+  Expression load(const Atom & sym, Environment & env) const;
+  Expression evalTree(const Expression & exp, Environment & env) const;
+  Expression callTree(const Expression & lambda, std::vector<Expression> & args,
+                      Environment & env) const;
+  const CompiledLambda * compiled(const Expression & lambda, std::uint64_t stamp,
+                                  const Environment & env);
+};
+
+#endif
@@ -0,0 +1,168 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "bytecode.hpp"
+#include "interpreter.hpp"
+#include "parse.hpp"
+#include "semantic_error.hpp"
+
+static Expression parse_program(const std::string & program){
+
+  std::istringstream iss(program);
+  return parse(tokenize(iss));
+}
+
+static Expression run_mode(const std::string & program, Interpreter::EvalMode mode){
+
+  std::istringstream iss(program);
+
+  Interpreter interp;
+  interp.setMode(mode);
+
+  bool ok = interp.parseStream(iss);
+  REQUIRE(ok == true);
+
+  return interp.evaluate();
+}
+
+TEST_CASE( "Test compiled instruction sequence", "[bytecode]" ) {
+
+  Environment env;
+
+  {
+    INFO("builtin call");
+    Chunk chunk = compile(parse_program("(+ 1 (* 2 x))"), env);
+
+    std::vector<OpCode> expected = {PushConst, PushConst, LoadGlobal, CallBuiltin,
+				    CallBuiltin, Return};
+    REQUIRE(chunk.code.size() == expected.size());
+    for(std::size_t i = 0; i < expected.size(); ++i){
+      REQUIRE(chunk.code[i].op == expected[i]);
+    }
+    REQUIRE(chunk.code[4].count == 2);
+  }
+
+  {
+    INFO("begin, define and closure call");
+    Chunk chunk = compile(parse_program("(begin (define a 1) (f a))"), env);
+
+    std::vector<OpCode> expected = {PushConst, Define, Pop, LoadGlobal, CallClosure, Return};
+    REQUIRE(chunk.code.size() == expected.size());
+    for(std::size_t i = 0; i < expected.size(); ++i){
+      REQUIRE(chunk.code[i].op == expected[i]);
+    }
+  }
+
+  {
+    INFO("other special forms are left to the tree walker");
+    Chunk chunk = compile(parse_program("(lambda (x) (+ x 1))"), env);
+
+    REQUIRE(chunk.code.size() == 2);
+    REQUIRE(chunk.code[0].op == EvalTree);
+  }
+}
+
+TEST_CASE( "Test bytecode matches the tree walker", "[bytecode]" ) {
+
+  std::vector<std::string> programs = {
+    "(+ 1 2)",
+    "(begin (define r 10) (* pi (* r r)))",
+    "(begin (define a (lambda (x y) (+ y x))) (a 1 1))",
+    "(begin (define f (lambda (x) (* x x))) (define g (lambda (y) (f (+ y 1)))) (g 2))",
+    "(begin (define g (lambda (y) (+ x y))) (define f (lambda (x) (g 1))) (f 5))",
+    "(begin (define f (lambda (x) (begin (define z (* x 2)) (+ z 1)))) (f 3))",
+    "(begin (define f (lambda (x) (list x (+ (* 2 x) 1)))) (map f (range -2 2 0.5)))",
+    "(begin (define f (lambda (x) (get-property \"a\" (set-property \"a\" x (list))))) (f 2))",
+    "(apply + (list 1 2 3))",
+    "(begin (define f (lambda (x) (sqrt (- x)))) (f 4))",
+    "(list)",
+    "(\"a string\")",
+    "(begin (define f (lambda (x) (begin (define x (* x 10)) (define y (+ x 1)) (list x y)))) (f 2))",
+    "(begin (define h (lambda (z) (+ x (+ y z)))) (define g (lambda (y) (h 1))) (define f (lambda (x) (g 2))) (f 3))",
+    "(begin (define g (lambda (s) (h 1))) (define h (lambda (y) (s y))) (g (lambda (q) 42)))",
+  };
+
+  for(auto & program : programs){
+    INFO(program);
+    Expression walked = run_mode(program, Interpreter::TreeWalk);
+    Expression compiled = run_mode(program, Interpreter::Bytecode);
+    REQUIRE(walked == compiled);
+  }
+
+  INFO("a caller's parameter cannot shadow a built-in either engine calls");
+  std::vector<std::string> rejected = {
+    "(begin (define g (lambda (sin) (h 1))) (define h (lambda (y) (sin y))) (g (lambda (q) 42)))",
+    "(begin (define g (lambda (sin) (h 1))) (define h (lambda (y) (sin y))) (g 5))",
+  };
+
+  for(auto & program : rejected){
+    INFO(program);
+    REQUIRE_THROWS_AS(run_mode(program, Interpreter::TreeWalk), SemanticError);
+    REQUIRE_THROWS_AS(run_mode(program, Interpreter::Bytecode), SemanticError);
+  }
+}
+
+TEST_CASE( "Test bytecode semantic errors", "[bytecode]" ) {
+
+  std::vector<std::string> programs = {
+    "(+ 1 a)",
+    "(@ none)",
+    "(1 2 3)",
+    "(define begin 1)",
+    "(begin (define f (lambda (x) x)) (f 1 2))",
+    "(begin (define f (lambda (x) (* x x))) (f 2) x)",
+  };
+
+  for(auto & program : programs){
+    INFO(program);
+    std::istringstream iss(program);
+
+    Interpreter interp;
+    interp.setMode(Interpreter::Bytecode);
+    REQUIRE(interp.parseStream(iss) == true);
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+}
+
+TEST_CASE( "Test bytecode keeps the environment between programs", "[bytecode]" ) {
+
+  Interpreter interp;
+  interp.setMode(Interpreter::Bytecode);
+  REQUIRE(interp.mode() == Interpreter::Bytecode);
+
+  std::istringstream first("(define f (lambda (x) (* 2 x)))");
+  REQUIRE(interp.parseStream(first) == true);
+  interp.evaluate();
+
+  std::istringstream second("(f 21)");
+  REQUIRE(interp.parseStream(second) == true);
+  REQUIRE(interp.evaluate() == Expression(42.));
+
+  INFO("redefinition is not served from the compiled body cache");
+  std::istringstream third("(begin (define f (lambda (x) (* 3 x))) (f 2))");
+  REQUIRE(interp.parseStream(third) == true);
+  REQUIRE(interp.evaluate() == Expression(6.));
+}
+
+TEST_CASE( "Test bytecode tail calls run in constant space", "[bytecode]" ) {
+
+  // without conditionals the loop ends on the error range raises once n > 0
+  std::string program =
+    "(begin (define g (lambda (n) (begin (define m (+ n 1)) (range m 0 1000000) (h m)))) "
+    "(define h (lambda (k) (g k))) (g -100000))";
+
+  Environment env;
+  VirtualMachine vm;
+  REQUIRE_THROWS_AS(vm.run(compile(parse_program(program), env), env), SemanticError);
+
+  INFO("the 100000 calls reuse the frame of the first");
+  REQUIRE(vm.maxDepth() == 1);
+
+  INFO("calls that are not in tail position push a frame each");
+  program = "(begin (define a (lambda (x) x)) (define b (lambda (x) (+ 1 (a x)))) (b 1))";
+  REQUIRE(vm.run(compile(parse_program(program), env), env) == Expression(2.));
+  REQUIRE(vm.maxDepth() == 2);
+}
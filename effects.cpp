@@ -0,0 +1,93 @@
+#include "effects.hpp"
+
+// the more severe of two effects
+static Expression::Effect worst(Expression::Effect a, Expression::Effect b){
+  return (a > b) ? a : b;
+}
+
+// predicate, sym is one of the parameters of the lambda being analyzed
+static bool is_param(const Expression & params, const Atom & sym){
+  for(auto p = params.tailConstBegin(); p != params.tailConstEnd(); ++p){
+    if(p->head() == sym) return true;
+  }
+  return false;
+}
+
+// record a call to sym, the effect of calling whatever it names
+static Expression::Effect call_effect(const Atom & sym, const Expression & params,
+                                      const Environment & env, std::vector<Atom> & procs){
+
+  if(is_param(params, sym) || !env.is_proc(sym) || env.is_local(sym)){
+    return Expression::ReadsGlobals;
+  }
+
+  for(auto & p : procs){
+    if(p == sym) return Expression::Pure;
+  }
+  procs.push_back(sym);
+  return Expression::Pure;
+}
+
+static Expression::Effect effect_of(const Expression & exp, const Expression & params,
+                                    const Environment & env, std::vector<Atom> & procs){
+
+  const Atom & head = exp.head();
+  bool leaf = (exp.tailConstBegin() == exp.tailConstEnd());
+
+  Expression::Effect effect = Expression::Pure;
+  auto first = exp.tailConstBegin();
+
+  switch(exp.form()){
+  case Expression::NoForm:
+    if(leaf){
+      if(head.isNumber() || head.isComplex()) return Expression::Pure;
+      if(head.isSymbol() && !head.asSymbol().empty() && (head.asSymbol()[0] == '"')){
+        return Expression::Pure;
+      }
+      return (head.isSymbol() && is_param(params, head)) ? Expression::Pure : Expression::ReadsGlobals;
+    }
+    effect = call_effect(head, params, env, procs);
+    break;
+  case Expression::ListForm:
+  case Expression::BeginForm:
+  case Expression::SetPropertyForm:
+  case Expression::GetPropertyForm:
+    break;
+  case Expression::DefineForm:
+    return Expression::Mutating;
+  case Expression::LambdaForm:
+    // building a lambda has no effect, calling it is a call like any other
+    return Expression::Pure;
+  case Expression::ApplyForm:
+  case Expression::MapForm:
+    // the first argument names the procedure called
+    if(leaf) return Expression::ReadsGlobals;
+    effect = first->head().isSymbol() ? call_effect(first->head(), params, env, procs)
+                                      : Expression::ReadsGlobals;
+    ++first;
+    break;
+  default:
+    // plots call a procedure by name, memo-stats changes between calls
+    effect = Expression::ReadsGlobals;
+    break;
+  }
+
+  for(auto e = first; e != exp.tailConstEnd(); ++e){
+    effect = worst(effect, effect_of(*e, params, env, procs));
+    if(effect == Expression::Mutating) break;
+  }
+  return effect;
+}
+
+Expression::Effect analyze_effects(const Expression & lambda, const Environment & env,
+                                   std::vector<Atom> & procs){
+
+  procs.clear();
+
+  if((lambda.form() != Expression::LambdaForm) ||
+     (lambda.tailConstEnd() - lambda.tailConstBegin() != 2)){
+    return Expression::Mutating;
+  }
+
+  return effect_of(*(lambda.tailConstBegin() + 1), *lambda.tailConstBegin(), env, procs);
+}
@@ -0,0 +1,33 @@
+/*! \file effects.hpp
+Defines the effect analysis run over the body of each lambda as it is built.
+
+A lambda is Pure when its value depends only on its arguments: the body
+refers to nothing but its parameters and literals, and calls only built-in
+procedures. It ReadsGlobals when it refers to free symbols or calls user
+lambdas, whose values may change between calls. It is Mutating when its body
+contains a define. set-property returns a new expression rather than
+changing its argument, so it does not make a lambda Mutating.
+ */
+#ifndef EFFECTS_HPP
+#define EFFECTS_HPP
+
+// system includes
+#include <vector>
+
+// module includes
+#include "atom.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \fn analyze_effects
+\brief classify the body of a lambda
+
+\param lambda the lambda expression, as built by the lambda special form
+\param env the environment the lambda is built in
+\param procs set to the built-in procedures called by the body
+\return the effect of calling the lambda
+ */
+Expression::Effect analyze_effects(const Expression & lambda, const Environment & env,
+                                   std::vector<Atom> & procs);
+
+#endif
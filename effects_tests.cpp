@@ -0,0 +1,83 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "effects.hpp"
+#include "environment.hpp"
+#include "parse.hpp"
+
+static Expression lambda_value(const std::string & program, Environment & env){
+
+  std::istringstream iss(program);
+  Expression exp = parse(tokenize(iss));
+  return exp.eval(env);
+}
+
+static Expression::Effect effect(const std::string & program){
+
+  Environment env;
+  std::vector<Atom> procs;
+  return analyze_effects(lambda_value(program, env), env, procs);
+}
+
+TEST_CASE( "Test effect analysis", "[effects]" ) {
+
+  {
+    INFO("parameters, literals and built-ins only");
+    Environment env;
+    std::vector<Atom> procs;
+    Expression lambda = lambda_value("(lambda (x y) (+ (sin x) (* 2 y) (sin y)))", env);
+    REQUIRE(analyze_effects(lambda, env, procs) == Expression::Pure);
+    REQUIRE(procs.size() == 3);
+  }
+
+  std::vector<std::string> pure = {
+    "(lambda (x) (list x (first (list 1 \"a\"))))",
+    "(lambda (x) (map sin (list x 1)))",
+    "(lambda (x) (get-property \"a\" (set-property \"a\" x (list))))",
+    "(lambda (x) (begin (lambda (y) y) x))",
+  };
+  for(auto & program : pure){
+    INFO(program);
+    REQUIRE(effect(program) == Expression::Pure);
+  }
+
+  std::vector<std::string> reads = {
+    "(lambda (x) (+ x y))",
+    "(lambda (x) (* x pi))",
+    "(lambda (x) (f x))",
+    "(lambda (f) (f 1))",
+    "(lambda (x) (map f (list x)))",
+    "(lambda (x) (continuous-plot f (list 0 x)))",
+  };
+  for(auto & program : reads){
+    INFO(program);
+    REQUIRE(effect(program) == Expression::ReadsGlobals);
+  }
+
+  std::vector<std::string> mutating = {
+    "(lambda (x) (begin (define y x) y))",
+    "(lambda (x) (f (define y x)))",
+  };
+  for(auto & program : mutating){
+    INFO(program);
+    REQUIRE(effect(program) == Expression::Mutating);
+  }
+}
+
+TEST_CASE( "Test effect stored on the closure", "[effects]" ) {
+
+  Environment env;
+
+  REQUIRE(lambda_value("(lambda (x) (* x x))", env).effect() == Expression::Pure);
+  REQUIRE(lambda_value("(lambda (x) (* x z))", env).effect() == Expression::ReadsGlobals);
+
+  INFO("copies and definitions keep it");
+  lambda_value("(define f (lambda (x) (begin (define y 1) x)))", env);
+  REQUIRE(env.get_exp(Atom("f")).effect() == Expression::Mutating);
+
+  INFO("other expressions are conservatively Mutating");
+  REQUIRE(Expression(Atom(1.)).effect() == Expression::Mutating);
+}
@@ -1,14 +1,19 @@
 #include "environment.hpp"
 
+#include <algorithm>
+#include <atomic>
 #include <cassert>
 #include <cmath>
 #include <complex>
+#include <thread>
+#include <utility>
 #include <vector>
 
 #include <iostream>
 
 #include "environment.hpp"
 #include "semantic_error.hpp"
+#include "simd.hpp"
 
 /*********************************************************************** 
 Helper Functions
@@ -109,6 +114,210 @@ Expression conjugate(const std::vector<Expression> &args)
 		throw SemanticError("Error in call for conjugate: invalid number of arguments");
 };
 
+/***********************************************************************
+The numeric builtins apply elementwise when an argument is a list, with
+the other arguments repeated for every element. The lists must have the
+same length. When every argument is a real number or a packed list the
+simd kernels compute the result; otherwise the builtin is called once per
+element, which also handles complex elements and nested lists.
+**********************************************************************/
+
+// true if some argument is a list, making the call elementwise
+static bool has_list(const std::vector<Expression> & args)
+{
+	for (auto & a : args) {
+		if (a.form() == Expression::ListForm)
+			return true;
+	}
+	return false;
+}
+
+// the length of the list arguments of an elementwise call
+static std::size_t list_length(const std::vector<Expression> & args, const std::string & name)
+{
+	bool found = false;
+	std::size_t length = 0;
+	for (auto & a : args) {
+		if (a.form() != Expression::ListForm)
+			continue;
+		const std::vector<double> * packed = a.packedNumbers();
+		std::size_t size = packed != nullptr ? packed->size() : a.tailConstEnd() - a.tailConstBegin();
+		if (found && size != length)
+			throw SemanticError("Error in call to " + name + ": lists of different lengths");
+		found = true;
+		length = size;
+	}
+	return length;
+}
+
+// the arguments of an elementwise call as arrays of doubles, when each is
+// a real number, broadcast, or a packed list
+class Operands {
+public:
+	Operands(const std::vector<Expression> & args, const std::string & name)
+		: length(list_length(args, name)), packed(true)
+	{
+		values.reserve(args.size());
+		for (auto & a : args) {
+			if (a.form() == Expression::ListForm && a.packedNumbers() != nullptr) {
+				data.push_back(a.packedNumbers()->data());
+				scalar.push_back(false);
+			}
+			else if (a.isBareNumber()) {
+				values.push_back(a.head().asNumber());
+				data.push_back(&values.back());
+				scalar.push_back(true);
+			}
+			else {
+				packed = false;
+			}
+		}
+	}
+
+	std::size_t length;
+	bool packed; // every argument is a number or a packed list
+	std::vector<const double *> data;
+	std::vector<bool> scalar;
+
+private:
+	std::vector<double> values; // the numbers, reserved so data stays valid
+};
+
+// call proc once per element of the list arguments
+static Expression elementwise(const std::vector<Expression> & args, Procedure proc, const std::string & name)
+{
+	std::size_t length = list_length(args, name);
+	std::vector<Expression> results;
+	results.reserve(length);
+	std::vector<Expression> element(args.size());
+	for (std::size_t i = 0; i < length; ++i) {
+		for (std::size_t j = 0; j < args.size(); ++j) {
+			if (args[j].form() != Expression::ListForm)
+				element[j] = args[j];
+			else if (args[j].packedNumbers() != nullptr)
+				element[j] = Expression((*args[j].packedNumbers())[i]);
+			else
+				element[j] = *(args[j].tailConstBegin() + i);
+		}
+		results.push_back(proc(element));
+	}
+	return listFunction(results);
+}
+
+// an elementwise call folding op over the arguments, from identity when
+// from_identity and from the first argument otherwise
+static Expression elementwise_fold(const std::vector<Expression> & args, BinaryOp op, bool from_identity,
+				   double identity, Procedure proc, const std::string & name)
+{
+	Operands operands(args, name);
+	if (!operands.packed)
+		return elementwise(args, proc, name);
+
+	std::vector<double> result(operands.length, identity);
+	std::size_t j = 0;
+	if (!from_identity) {
+		if (operands.scalar[0])
+			std::fill(result.begin(), result.end(), *operands.data[0]);
+		else
+			std::copy(operands.data[0], operands.data[0] + result.size(), result.begin());
+		j = 1;
+	}
+	for (; j < args.size(); ++j)
+		simd_binary(op, result.data(), false, operands.data[j], operands.scalar[j], result.data(), result.size());
+	return Expression(Atom("list"), std::move(result));
+}
+
+// an elementwise call of a function of one argument
+static Expression elementwise_unary(const std::vector<Expression> & args, UnaryOp op, Procedure proc, const std::string & name)
+{
+	const std::vector<double> * packed = args[0].packedNumbers();
+	if (packed == nullptr)
+		return elementwise(args, proc, name);
+
+	std::vector<double> result(packed->size());
+	simd_unary(op, packed->data(), result.data(), result.size());
+	return Expression(Atom("list"), std::move(result));
+}
+
+/***********************************************************************
+The arithmetic builtins classify their arguments once per call and then
+run the loop for that kind, so calls on real numbers never touch complex
+arithmetic.
+**********************************************************************/
+
+// the numbers among the arguments of an arithmetic builtin
+enum ArgsKind { RealArgs, ComplexArgs, NotNumbers };
+
+static ArgsKind number_kind(const std::vector<Expression> & args)
+{
+	ArgsKind kind = RealArgs;
+	for (auto & a : args) {
+		if (a.isHeadComplex())
+			kind = ComplexArgs;
+		else if (!a.isHeadNumber())
+			return NotNumbers;
+	}
+	return kind;
+}
+
+// the kinds of the two arguments of a binary builtin
+enum PairKind { RealReal, RealComplex, ComplexReal, ComplexComplex, NotNumberPair };
+
+static PairKind pair_kind(const Expression & a, const Expression & b)
+{
+	if (a.isHeadNumber() && b.isHeadNumber())
+		return RealReal;
+	if (a.isHeadNumber() && b.isHeadComplex())
+		return RealComplex;
+	if (a.isHeadComplex() && b.isHeadNumber())
+		return ComplexReal;
+	if (a.isHeadComplex() && b.isHeadComplex())
+		return ComplexComplex;
+	return NotNumberPair;
+}
+
+// the sum and product of real arguments
+static double real_sum(const std::vector<Expression> & args)
+{
+	double sum = 0;
+	for (auto & a : args)
+		sum += a.head().asNumber();
+	return sum;
+}
+
+static double real_product(const std::vector<Expression> & args)
+{
+	double product = 1;
+	for (auto & a : args)
+		product *= a.head().asNumber();
+	return product;
+}
+
+// the sum and product of arguments some of which are complex
+static std::complex<double> complex_sum(const std::vector<Expression> & args)
+{
+	std::complex<double> sum;
+	for (auto & a : args) {
+		if (a.isHeadNumber())
+			sum += a.head().asNumber();
+		else
+			sum += a.head().asComplex();
+	}
+	return sum;
+}
+
+static std::complex<double> complex_product(const std::vector<Expression> & args)
+{
+	std::complex<double> product(1, 0);
+	for (auto & a : args) {
+		if (a.isHeadNumber())
+			product *= a.head().asNumber();
+		else
+			product *= a.head().asComplex();
+	}
+	return product;
+}
+
 /*********************************************************************** 
 Each of the functions below have the signature that corresponds to the
 typedef'd Procedure function pointer.
@@ -122,160 +331,113 @@ Expression default_proc(const std::vector<Expression> & args){
 
 Expression add(const std::vector<Expression> & args)
 {
+  if (has_list(args))
+	  return elementwise_fold(args, AddOp, true, 0, add, "add");
+  if (args.size() == 0)
+	  throw SemanticError("Error in add: no arguments input");
 
-  // check all aruments are numbers, while adding
-  std::complex<double> result;
-  bool isC = false;
-  if (args.size() != 0) {
-	  for (auto & a : args) {
-		  if (a.isHeadNumber()) {
-			  result += a.head().asNumber();
-		  }
-		  else if (a.isHeadComplex()) {
-			  isC = true;
-			  result += a.head().asComplex();
-		  }
-		  else {
-			  throw SemanticError("Error in call to add, argument not a number");
-		  }
-	  }
-	  if (isC)
-		  return Expression(result);
-	  else
-		  return Expression(result.real());
+  switch (number_kind(args)) {
+  case RealArgs:
+	  return Expression(real_sum(args));
+  case ComplexArgs:
+	  return Expression(complex_sum(args));
+  default:
+	  throw SemanticError("Error in call to add, argument not a number");
   }
-  else
-	  throw SemanticError("Error in add: no arguments input");
 }
 
 Expression mul(const std::vector<Expression> & args)
 {
- 
-	// check all aruments are numbers, while multiplying
-	Expression result;
-	std::complex<double> c_result(1, 0);
-	bool c_true = false;
-		for (auto & a : args) {
-			if (a.head().isComplex()) {
-				c_true = true;
-				c_result *= a.head().asComplex();
-
-			}
-			else if (a.isHeadNumber()) {
-				c_result *= a.head().asNumber();
-
-			}
-			else {
-				throw SemanticError("Error in call to mul, argument not a number");
-			}
-		}
-
-		if (c_true)
-			result = Expression(c_result);
-
-		else if (!c_true)
-			result = Expression(c_result.real());
-	
-		return result;
-
+	if (has_list(args))
+		return elementwise_fold(args, MulOp, true, 1, mul, "mul");
+
+	switch (number_kind(args)) {
+	case RealArgs:
+		return Expression(real_product(args));
+	case ComplexArgs:
+		return Expression(complex_product(args));
+	default:
+		throw SemanticError("Error in call to mul, argument not a number");
+	}
 }
 
 Expression subneg(const std::vector<Expression> & args)
 {
-	Expression result;
-  std::complex<double> c_result (1, 0);
-  bool isC = false;
-  // preconditions
+  if (has_list(args) && nargs_equal(args, 1))
+	  return elementwise_fold(args, MulOp, true, -1, subneg, "subtraction or negation");
+  if (has_list(args) && nargs_equal(args, 2))
+	  return elementwise_fold(args, SubOp, false, 0, subneg, "subtraction or negation");
+
   if(nargs_equal(args,1)){
-    if(args[0].isHeadNumber()){
-      c_result = -args[0].head().asNumber();
-    }
-	else if (args[0].isHeadComplex()) {
-		isC = true;
-		c_result = -args[0].head().asComplex();
-	}
-   
+	  switch (number_kind(args)) {
+	  case RealArgs:
+		  return Expression(-args[0].head().asNumber());
+	  case ComplexArgs:
+		  return Expression(-args[0].head().asComplex());
+	  default:
+		  return Expression(1.);
+	  }
   }
   else if(nargs_equal(args,2)){
-    if( (args[0].isHeadNumber()) && (args[1].isHeadNumber()) ){
-      c_result = args[0].head().asNumber() - args[1].head().asNumber();
-    }
-	else if (args[0].isHeadComplex() && args[1].isHeadNumber())
-	{
-	 isC = true;
-		c_result = args[0].head().asComplex() - args[1].head().asNumber();
-	}
-	else if (args[0].isHeadNumber() && args[1].isHeadComplex())
-	{
-		isC = true;
-		c_result = args[0].head().asNumber() - args[1].head().asComplex();
-	}
-	else if (args[0].isHeadComplex() && args[1].isHeadComplex())
-	{
-		isC = true;
-		c_result = args[0].head().asComplex() - args[1].head().asComplex();
-	}
+	  const Atom & a = args[0].head();
+	  const Atom & b = args[1].head();
+	  switch (pair_kind(args[0], args[1])) {
+	  case RealReal:
+		  return Expression(a.asNumber() - b.asNumber());
+	  case RealComplex:
+		  return Expression(a.asNumber() - b.asComplex());
+	  case ComplexReal:
+		  return Expression(a.asComplex() - b.asNumber());
+	  case ComplexComplex:
+		  return Expression(a.asComplex() - b.asComplex());
+	  default:
+		  return Expression(1.);
+	  }
   }
   else{
     throw SemanticError("Error in call to subtraction or negation: invalid number of arguments.");
   }
-  if (isC) 
-	  result = Expression(c_result);
-  else if (!isC)
-	  result = Expression(c_result.real());
-
-  return result;
 }
 
 Expression div(const std::vector<Expression> & args)
 {
-	Expression exresult;
-  std::complex<double> c_result (0, 0);
-  double result = 0;  
-  bool isC = false;
+  if (has_list(args) && nargs_equal(args, 1))
+	  return elementwise_fold(args, DivOp, true, 1, div, "division");
+  if (has_list(args) && nargs_equal(args, 2))
+	  return elementwise_fold(args, DivOp, false, 0, div, "division");
+
   if(nargs_equal(args,2))
   {
-    if( (args[0].isHeadNumber()) && (args[1].isHeadNumber()) )
-	{
-      result = args[0].head().asNumber() / args[1].head().asNumber();
-    }
-	else if (args[0].isHeadComplex() || args[1].isHeadComplex()) 
-	{
-		isC = true;
-		if (args[0].isHeadComplex() && args[1].isHeadNumber())
-		{
-			c_result = args[0].head().asComplex() / args[1].head().asNumber();
-		}
-		else if (args[0].isHeadNumber() && args[1].isHeadComplex())
-		{
-			c_result = args[0].head().asNumber() / args[1].head().asComplex();
-		}
-		else if (args[0].isHeadComplex() && args[1].isHeadComplex())
-		{
-			c_result = args[0].head().asComplex() / args[1].head().asComplex();
-		}
-	}
+	  const Atom & a = args[0].head();
+	  const Atom & b = args[1].head();
+	  switch (pair_kind(args[0], args[1])) {
+	  case RealReal:
+		  return Expression(a.asNumber() / b.asNumber());
+	  case RealComplex:
+		  return Expression(a.asNumber() / b.asComplex());
+	  case ComplexReal:
+		  return Expression(a.asComplex() / b.asNumber());
+	  case ComplexComplex:
+		  return Expression(a.asComplex() / b.asComplex());
+	  default:
+		  return Expression(0.);
+	  }
   }
   else if (nargs_equal(args, 1))
   {
-	  if (args[0].isHeadNumber()) {
-		  result = 1 / args[0].head().asNumber();
-	  }
-	  else if (args[0].isHeadComplex()) {
-		  isC = true;
-		  c_result = conj(args[0].head().asComplex());
+	  switch (number_kind(args)) {
+	  case RealArgs:
+		  return Expression(1 / args[0].head().asNumber());
+	  case ComplexArgs:
+		  return Expression(conj(args[0].head().asComplex()));
+	  default:
+		  return Expression(0.);
 	  }
   }
   else
   {
     throw SemanticError("Error in call to division: invalid number of arguments.");
   }
-  if (isC)
-	  exresult = Expression(c_result);
-  else if (!isC)
-	  exresult = Expression(result);
-
-  return exresult;
 }
 
 Expression sqrt(const std::vector<Expression> & args)
@@ -285,6 +447,14 @@ Expression sqrt(const std::vector<Expression> & args)
 	std::complex<double> result (0, 0);
 	std::complex<double> I(0, 1);
 	bool isC = false;
+	if (has_list(args) && nargs_equal(args, 1))
+	{
+		// negative elements have complex roots
+		const std::vector<double> * packed = args[0].packedNumbers();
+		if (packed != nullptr && std::all_of(packed->begin(), packed->end(), [](double x) { return x >= 0; }))
+			return elementwise_unary(args, SqrtOp, sqrt, "square root");
+		return elementwise(args, sqrt, "square root");
+	}
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -322,6 +492,8 @@ Expression exp(const std::vector<Expression> & args)
 	double result = 0;
 	std::complex<double> c_result(0, 0);
 	bool isC = false;
+	if (has_list(args) && nargs_equal(args, 2))
+		return elementwise_fold(args, PowOp, false, 0, exp, "exponent");
 	if (nargs_equal(args, 2))
 	{
 		if ((args[0].isHeadNumber()) && (args[1].isHeadNumber()))
@@ -361,6 +533,8 @@ Expression natLog(const std::vector<Expression> & args)
 	Expression eresult;
 	std::complex<double> result (0, 0);
 	bool isC = false;
+	if (has_list(args) && nargs_equal(args, 1))
+		return elementwise_unary(args, LogOp, natLog, "ln");
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -389,6 +563,8 @@ Expression sin(const std::vector<Expression> & args)
 	Expression eresult;
 	std::complex<double> result(0, 0);
 	bool isC = false;
+	if (has_list(args) && nargs_equal(args, 1))
+		return elementwise_unary(args, SinOp, sin, "sin");
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -417,6 +593,8 @@ Expression cos(const std::vector<Expression> & args)
 	Expression eresult;
 	std::complex<double> result(0, 0);
 	bool isC = false;
+	if (has_list(args) && nargs_equal(args, 1))
+		return elementwise_unary(args, CosOp, cos, "cos");
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -445,6 +623,8 @@ Expression tan(const std::vector<Expression> & args)
 	Expression eresult;
 	std::complex<double> result(0, 0);
 	bool isC = false;
+	if (has_list(args) && nargs_equal(args, 1))
+		return elementwise_unary(args, TanOp, tan, "tan");
 	if (nargs_equal(args, 1))
 	{
 		if (args[0].isHeadNumber())
@@ -470,9 +650,26 @@ Expression tan(const std::vector<Expression> & args)
 	return eresult;
 }
 
+// the numbers of args if every one is a bare number, so the list of them
+// can be packed
+static bool all_numbers(const std::vector<Expression> & args, std::vector<double> & numbers)
+{
+	numbers.reserve(args.size());
+	for (auto & a : args) {
+		if (!a.isBareNumber())
+			return false;
+		numbers.push_back(a.head().asNumber());
+	}
+	return !numbers.empty();
+}
+
 Expression listFunction(const std::vector<Expression> & args)
 {
 	Atom HEAD("list");
+	std::vector<double> numbers;
+	if (all_numbers(args, numbers))
+		return Expression(HEAD, std::move(numbers));
+
 	Expression myList {HEAD};
 	//where did you come from where did you go, where did you come from counter-eyed-joe
 	int counter = 0;//whaddafuqisdat
@@ -493,7 +690,11 @@ Expression first(const std::vector<Expression> & args)
 {
 	Expression myList;
 	if (nargs_equal(args, 1)){
-		if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
+		if (args[0].packedNumbers() != nullptr) {
+			if (args[0].head().asSymbol() == "list")
+				myList = Expression(args[0].packedNumbers()->front());
+		}
+		else if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
 			if (args[0].head().asSymbol() == "list")
 				myList = *(args[0].tailConstBegin());
 		}
@@ -512,7 +713,12 @@ Expression rest(const std::vector<Expression> & args)
 	Expression myList{HEAD};
 	if (nargs_equal(args, 1)) {
 		if (args[0].head().asSymbol() == "list") {
-			if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
+			const std::vector<double> * packed = args[0].packedNumbers();
+			if (packed != nullptr) {
+				if (packed->size() > 1)
+					myList = Expression(HEAD, std::vector<double>(packed->begin() + 1, packed->end()));
+			}
+			else if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
 				for (auto e = args[0].tailConstBegin() + 1; e != args[0].tailConstEnd(); e++) {
 					myList.appendExpression(*e);
 				}
@@ -537,8 +743,12 @@ Expression length(const std::vector<Expression> & args)
 		//if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
 		
 			if (args[0].head().asSymbol() == "list") {
-				for (auto e = args[0].tailConstBegin(); e != args[0].tailConstEnd(); e++) {
-					length++;
+				if (args[0].packedNumbers() != nullptr)
+					length = static_cast<double>(args[0].packedNumbers()->size());
+				else {
+					for (auto e = args[0].tailConstBegin(); e != args[0].tailConstEnd(); e++) {
+						length++;
+					}
 				}
 				myLength.append(length);
 			}
@@ -556,6 +766,24 @@ Expression append(const std::vector<Expression> & args)
 	Atom HEAD("list");
 	Expression appList{ HEAD };
 	if (nargs_equal(args, 2)) {
+		const std::vector<double> * packed = args[0].packedNumbers();
+		if (packed != nullptr && args[0].head().asSymbol() == "list") {
+			// stays packed when a number or another packed list is appended
+			std::vector<double> numbers;
+			if (args[1].isBareNumber()) {
+				numbers.reserve(packed->size() + 1);
+				numbers.assign(packed->begin(), packed->end());
+				numbers.push_back(args[1].head().asNumber());
+				return Expression(HEAD, std::move(numbers));
+			}
+			const std::vector<double> * more = args[1].packedNumbers();
+			if (more != nullptr && args[1].head().asSymbol() == "list") {
+				numbers.reserve(packed->size() + more->size());
+				numbers.assign(packed->begin(), packed->end());
+				numbers.insert(numbers.end(), more->begin(), more->end());
+				return Expression(HEAD, std::move(numbers));
+			}
+		}
 		if (args[0].tailConstBegin() != args[0].tailConstEnd()) {
 			if (args[0].head().asSymbol() == "list") {
 				for (auto e = args[0].tailConstBegin(); e != args[0].tailConstEnd(); e++) {
@@ -584,6 +812,15 @@ Expression join(const std::vector<Expression> & args)
 	Expression joinList{ HEAD };
 	if (nargs_equal(args, 2)) {
 		if (args[0].head().asSymbol() == "list" && args[1].head().asSymbol() == "list") {
+			const std::vector<double> * left = args[0].packedNumbers();
+			const std::vector<double> * right = args[1].packedNumbers();
+			if (left != nullptr && right != nullptr) {
+				std::vector<double> numbers;
+				numbers.reserve(left->size() + right->size());
+				numbers.assign(left->begin(), left->end());
+				numbers.insert(numbers.end(), right->begin(), right->end());
+				return Expression(HEAD, std::move(numbers));
+			}
 			for (auto e = args[0].tailConstBegin(); e != args[0].tailConstEnd(); e++) {
 				joinList.appendExpression(*e);
 			}
@@ -610,11 +847,13 @@ Expression range(const std::vector<Expression> & args)
 		if (args[0].isHeadNumber() && args[1].isHeadNumber() && args[2].isHeadNumber()) {
 			if (args[0].head().asNumber() < args[1].head().asNumber()) {
 				if (args[2].head().asNumber() > 0) {
+					std::vector<double> numbers;
 					double i = first;
 					while (i <= second) {
-						rangeList.append(i);
+						numbers.push_back(i);
 						i = i + third;
 					}
+					rangeList = Expression(HEAD, std::move(numbers));
 				}
 				else
 					throw SemanticError("Error in call to range: negative or zero increment in range");
@@ -663,38 +902,203 @@ const std::complex<double> I(0, 1);
 const double PI = std::atan2(0, -1);
 const double EXP = std::exp(1);
 
-Environment::Environment(){
+// every definition gets a stamp no other definition, in any environment,
+// will ever share, so a stamp identifies what a symbol was bound to
+static std::atomic<std::uint64_t> next_stamp(1);
+
+Environment::EnvResult::EnvResult(EnvResultType t, Expression e)
+  : type(t), exp(std::move(e)), stamp(next_stamp++){}
+
+Environment::Environment()
+  : parent(nullptr), version_stamp(0), memoize_lambdas(false),
+    map_thread_count(std::max(1u, std::thread::hardware_concurrency())){
 
   reset();
 }
 
+Environment::Environment(const Environment * parent)
+  : parent(parent), version_stamp(0), memoize_lambdas(false), map_thread_count(1){}
+
+Environment::Environment(const Environment & other)
+  : names(other.names), entries(other.entries), slots(other.slots),
+    parent(other.parent), version_stamp(next_stamp++), memoize_lambdas(other.memoize_lambdas),
+    map_thread_count(other.map_thread_count){}
+
+Environment & Environment::operator=(const Environment & other){
+
+  if(this != &other){
+    names = other.names;
+    entries = other.entries;
+    slots = other.slots;
+    parent = other.parent;
+    version_stamp = next_stamp++;
+    memoize_lambdas = other.memoize_lambdas;
+    map_thread_count = other.map_thread_count;
+  }
+
+  return *this;
+}
+
+bool Environment::find(const Atom & sym, std::size_t & index) const{
+
+  if(parent == nullptr){
+    // the global frame indexes by symbol id
+    std::size_t id = sym.symbolId();
+    if((id < slots.size()) && (slots[id] != 0)){
+      index = slots[id] - 1;
+      return true;
+    }
+    return false;
+  }
+
+  // local frames are small, search them in order
+  for(std::size_t i = 0; i < names.size(); ++i){
+    if(names[i] == sym){
+      index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+const Environment::EnvResult * Environment::lookup(const Atom & sym) const{
+  if(!sym.isSymbol()) return nullptr;
+
+  // walk the scope chain from the innermost frame outwards
+  for(const Environment * frame = this; frame != nullptr; frame = frame->parent){
+    std::size_t index = 0;
+    if(frame->find(sym, index)){
+      return &frame->entries[index];
+    }
+  }
+
+  return nullptr;
+}
+
+void Environment::bind(const Atom & sym, EnvResult && result){
+
+  if(parent == nullptr){
+    version_stamp = next_stamp++;
+  }
+
+  std::size_t index = 0;
+  if(find(sym, index)){
+    entries[index] = std::move(result);
+    return;
+  }
+
+  if(parent == nullptr){
+    std::size_t id = sym.symbolId();
+    if(id >= slots.size()){
+      slots.resize(id + 1, 0);
+    }
+    slots[id] = entries.size() + 1;
+  }
+
+  names.push_back(sym);
+  entries.push_back(std::move(result));
+}
+
 bool Environment::is_known(const Atom & sym) const{
-  if(!sym.isSymbol()) return false;
-  
-  return envmap.find(sym.asSymbol()) != envmap.end();
+
+  return lookup(sym) != nullptr;
 }
 
 bool Environment::is_exp(const Atom & sym) const{
-  if(!sym.isSymbol()) return false;
-  
-  auto result = envmap.find(sym.asSymbol());
-  return (result != envmap.end()) && (result->second.type == ExpressionType);
+
+  const EnvResult * result = lookup(sym);
+  return (result != nullptr) && (result->type == ExpressionType);
 }
 
 Expression Environment::get_exp(const Atom & sym) const{
 
   Expression exp;
-  
-  if(sym.isSymbol()){
-    auto result = envmap.find(sym.asSymbol());
-    if((result != envmap.end()) && (result->second.type == ExpressionType)){
-      exp = result->second.exp;
-    }
+
+  const EnvResult * result = lookup(sym);
+  if((result != nullptr) && (result->type == ExpressionType)){
+    exp = result->exp;
   }
 
   return exp;
 }
 
+const Expression * Environment::find_local(std::size_t slot, const Atom & sym,
+                                            std::size_t depth) const{
+
+  const Environment * frame = this;
+  std::size_t index = 0;
+  for(; (depth > 0) && (frame->parent != nullptr); --depth){
+    if(frame->find(sym, index)){
+      const EnvResult & nearer = frame->entries[index];
+      return (nearer.type == ExpressionType) ? &nearer.exp : nullptr;
+    }
+    frame = frame->parent;
+  }
+
+  if((frame->parent != nullptr) && (slot < frame->names.size()) &&
+     (frame->names[slot] == sym) && (frame->entries[slot].type == ExpressionType)){
+    return &frame->entries[slot].exp;
+  }
+
+  return nullptr;
+}
+
+bool Environment::is_local(const Atom & sym) const{
+  if(!sym.isSymbol()) return false;
+
+  std::size_t index = 0;
+  for(const Environment * frame = this; frame->parent != nullptr; frame = frame->parent){
+    if(frame->find(sym, index)) return true;
+  }
+  return false;
+}
+
+std::uint64_t Environment::version() const noexcept{
+
+  const Environment * frame = this;
+  while(frame->parent != nullptr){
+    frame = frame->parent;
+  }
+  return frame->version_stamp;
+}
+
+void Environment::set_auto_memoize(bool enable) noexcept{
+  memoize_lambdas = enable;
+}
+
+bool Environment::auto_memoize() const noexcept{
+
+  const Environment * frame = this;
+  while(frame->parent != nullptr){
+    frame = frame->parent;
+  }
+  return frame->memoize_lambdas;
+}
+
+void Environment::set_map_threads(std::size_t threads) noexcept{
+  map_thread_count = std::max<std::size_t>(1, threads);
+}
+
+std::size_t Environment::map_threads() const noexcept{
+
+  const Environment * frame = this;
+  while(frame->parent != nullptr){
+    frame = frame->parent;
+  }
+  return frame->map_thread_count;
+}
+
+const Expression * Environment::find_exp(const Atom & sym, std::uint64_t & stamp) const{
+
+  const EnvResult * result = lookup(sym);
+  if((result != nullptr) && (result->type == ExpressionType)){
+    stamp = result->stamp;
+    return &result->exp;
+  }
+
+  return nullptr;
+}
+
 void Environment::add_exp(const Atom & sym, const Expression & exp){
 
   if(!sym.isSymbol()){
@@ -705,19 +1109,13 @@ void Environment::add_exp(const Atom & sym, const Expression & exp){
   {
 	  throw SemanticError("error");
   }
-  /// error if overwriting symbol map
-  if(envmap.find(sym.asSymbol()) != envmap.end()){
-	  envmap[sym.asSymbol()] = EnvResult(ExpressionType, exp);
-  }
-
-  envmap.emplace(sym.asSymbol(), EnvResult(ExpressionType, exp)); 
+  bind(sym, EnvResult(ExpressionType, exp));
 }
 
 bool Environment::is_proc(const Atom & sym) const{
-  if(!sym.isSymbol()) return false;
-  
-  auto result = envmap.find(sym.asSymbol());
-  return (result != envmap.end()) && (result->second.type == ProcedureType);
+
+  const EnvResult * result = lookup(sym);
+  return (result != nullptr) && (result->type == ProcedureType);
 }
 
 
@@ -725,11 +1123,9 @@ Procedure Environment::get_proc(const Atom & sym) const{
 
   //Procedure proc = default_proc;
 
-  if(sym.isSymbol()){
-    auto result = envmap.find(sym.asSymbol());
-    if((result != envmap.end()) && (result->second.type == ProcedureType)){
-      return result->second.proc;
-    }
+  const EnvResult * result = lookup(sym);
+  if((result != nullptr) && (result->type == ProcedureType)){
+    return result->proc;
   }
 
   return default_proc;
@@ -744,88 +1140,90 @@ then re-add the default ones.
  */
 void Environment::reset(){
 
-  envmap.clear();
+  names.clear();
+  entries.clear();
+  slots.clear();
   
   // Built-In value of pi
-  envmap.emplace("pi", EnvResult(ExpressionType, Expression(PI)));
+  bind(Atom("pi"), EnvResult(ExpressionType, Expression(PI)));
 
   // Built-In value of e
-  envmap.emplace("e", EnvResult(ExpressionType, Expression(EXP)));
+  bind(Atom("e"), EnvResult(ExpressionType, Expression(EXP)));
 
   // Built-In value of i
-  envmap.emplace("I", EnvResult(ExpressionType, Expression(I)));
+  bind(Atom("I"), EnvResult(ExpressionType, Expression(I)));
 
   // Procedure: add;
-  envmap.emplace("+", EnvResult(ProcedureType, add)); 
+  bind(Atom("+"), EnvResult(ProcedureType, add)); 
 
   // Procedure: subneg;
-  envmap.emplace("-", EnvResult(ProcedureType, subneg)); 
+  bind(Atom("-"), EnvResult(ProcedureType, subneg)); 
 	
   // Procedure: mul;
-  envmap.emplace("*", EnvResult(ProcedureType, mul)); 
+  bind(Atom("*"), EnvResult(ProcedureType, mul)); 
 
   // Procedure: div;
-  envmap.emplace("/", EnvResult(ProcedureType, div));
+  bind(Atom("/"), EnvResult(ProcedureType, div));
 
   //Procedure: sqrt;
-  envmap.emplace("sqrt", EnvResult(ProcedureType, sqrt));
+  bind(Atom("sqrt"), EnvResult(ProcedureType, sqrt));
   
   //Procedure: exp;
-  envmap.emplace("^", EnvResult(ProcedureType, exp));
+  bind(Atom("^"), EnvResult(ProcedureType, exp));
 
   //Procedure: ln;
-  envmap.emplace("ln", EnvResult(ProcedureType, natLog));
+  bind(Atom("ln"), EnvResult(ProcedureType, natLog));
 
   //Procedure: sin;
-  envmap.emplace("sin", EnvResult(ProcedureType, sin));
+  bind(Atom("sin"), EnvResult(ProcedureType, sin));
 
   //Procedure: cos;
-  envmap.emplace("cos", EnvResult(ProcedureType, cos));
+  bind(Atom("cos"), EnvResult(ProcedureType, cos));
 
   //Procedure: tan;
-  envmap.emplace("tan", EnvResult(ProcedureType, tan));
+  bind(Atom("tan"), EnvResult(ProcedureType, tan));
 
   //Procedure: real;
-  envmap.emplace("real", EnvResult(ProcedureType, realPart));
+  bind(Atom("real"), EnvResult(ProcedureType, realPart));
 
   //Procedure: imaginary;
-  envmap.emplace("imag", EnvResult(ProcedureType, imagPart));
+  bind(Atom("imag"), EnvResult(ProcedureType, imagPart));
 
   //Procedure: magnitude;
-  envmap.emplace("mag", EnvResult(ProcedureType, magnitude));
+  bind(Atom("mag"), EnvResult(ProcedureType, magnitude));
 
   //Procedure: phase/angle;
-  envmap.emplace("arg", EnvResult(ProcedureType, anglePhase));
+  bind(Atom("arg"), EnvResult(ProcedureType, anglePhase));
 
   //Procedure: conjugate;
-  envmap.emplace("conj", EnvResult(ProcedureType, conjugate));
+  bind(Atom("conj"), EnvResult(ProcedureType, conjugate));
 
   //Procedure: list;
-  envmap.emplace("list", EnvResult(ProcedureType, listFunction));
+  bind(Atom("list"), EnvResult(ProcedureType, listFunction));
 
   //Procedure: first;
-  envmap.emplace("first", EnvResult(ProcedureType, first));
+  bind(Atom("first"), EnvResult(ProcedureType, first));
 
   //Procedure: rest;
-  envmap.emplace("rest", EnvResult(ProcedureType, rest));
+  bind(Atom("rest"), EnvResult(ProcedureType, rest));
 
   //Procedure: length;
-  envmap.emplace("length", EnvResult(ProcedureType, length));
+  bind(Atom("length"), EnvResult(ProcedureType, length));
 
   //Procedure: append;
-  envmap.emplace("append", EnvResult(ProcedureType, append));
+  bind(Atom("append"), EnvResult(ProcedureType, append));
 
   //Procedure: join;
-  envmap.emplace("join", EnvResult(ProcedureType, join));
+  bind(Atom("join"), EnvResult(ProcedureType, join));
 
   //Procedure: range;
-  envmap.emplace("range", EnvResult(ProcedureType, range));
+  bind(Atom("range"), EnvResult(ProcedureType, range));
 
   //Procedure: discrete plot;
-  envmap.emplace("discrete-plot", EnvResult(ProcedureType, discrete_plot));
+  bind(Atom("discrete-plot"), EnvResult(ProcedureType, discrete_plot));
   //Procedure: set-property;
-  //envmap.emplace("set-property", EnvResult(ProcedureType, setProperty));
+  //bind(Atom("set-property"), EnvResult(ProcedureType, setProperty));
 
   //Procedure: get-property;
-//  envmap.emplace("get-property", EnvResult(ProcedureType, getProperty));
+//  bind(Atom("get-property"), EnvResult(ProcedureType, getProperty));
 }
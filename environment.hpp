@@ -11,7 +11,9 @@ needed.
 #define ENVIRONMENT_HPP
 
 // system includes
-#include <map>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
 
 
 // module includes
@@ -37,6 +39,20 @@ return you can obtain
 the mapped-to value using get_exp or get_proc.
 
 To add an symbol to expression mapping use the add_exp member function.
+
+Environments form a scope chain. A local frame, e.g. the one pushed for the
+duration of a lambda call, holds only its own definitions and forwards any
+lookup it cannot satisfy to its parent frame. Frames never copy their parent.
+
+The frame of a lambda call is chained to the environment of the caller, not
+the one the lambda was defined in, so a lambda sees the bindings of its
+callers. Scoping is dynamic, as it was when a call copied the environment of
+its caller.
+
+The global frame is indexed by interned symbol id. A local frame keeps its
+bindings in definition order, so the parameters of a lambda call occupy
+slots 0 to n-1 and can be read by position with find_local, in this frame
+or one a known number of frames out.
  */
 class Environment {
 public:
@@ -44,6 +60,17 @@ public:
    * definitions. */
   Environment();
 
+  /*! Construct an empty local frame chained to a parent environment.
+    \param parent the enclosing environment, must outlive this frame
+   */
+  explicit Environment(const Environment * parent);
+
+  /// copy an environment, the copy starts a new version
+  Environment(const Environment & other);
+
+  /// assign an environment, the result starts a new version
+  Environment & operator=(const Environment & other);
+
   /*! Determine if a symbol is known to the environment.
     \param sym the sumbol to lookup
     \return true if the symbol has been defined in the environment
@@ -63,7 +90,58 @@ public:
   */
   Expression get_exp(const Atom &sym) const;
 
-  /*! Add a mapping from sym argument to the exp argument within the environment.
+  /*! Find the Expression the argument symbol maps to without copying it.
+    \param sym the symbol to lookup
+    \param stamp set to the stamp of the mapping, unique to each add_exp call
+    \return the stored expression or nullptr, valid until the frame holding
+    it is next modified
+  */
+  const Expression * find_exp(const Atom &sym, std::uint64_t &stamp) const;
+
+  /*! Find the Expression bound to a slot of a local frame without copying it.
+    A binding of sym in a frame nearer than depth hides the slot and is
+    returned instead.
+    \param slot the position of the binding in the frame
+    \param sym the symbol expected in that slot
+    \param depth the number of frames out from this one
+    \return the stored expression, or nullptr if the slot does not bind sym
+    to an expression
+  */
+  const Expression * find_local(std::size_t slot, const Atom &sym,
+                                std::size_t depth = 0) const;
+
+  /*! Determine if a symbol is bound in a local frame of the scope chain
+    \param sym the symbol to check for
+    \return true if a frame other than the global one binds sym
+  */
+  bool is_local(const Atom &sym) const;
+
+  /*! The version of the global frame. Every definition made in the global
+    frame changes it, and versions are never reused, so a value resolved
+    there can be cached against it.
+    \return the current version
+  */
+  std::uint64_t version() const noexcept;
+
+  /*! Select whether lambdas found to be pure are memoized when built.
+    Takes effect when called on the global environment.
+    \param enable true to memoize
+  */
+  void set_auto_memoize(bool enable) noexcept;
+
+  /// true if pure lambdas are memoized when built
+  bool auto_memoize() const noexcept;
+
+  /*! Select the number of threads map may use for a large list.
+    Takes effect when called on the global environment.
+    \param threads the thread count, 1 to map on the calling thread only
+  */
+  void set_map_threads(std::size_t threads) noexcept;
+
+  /// the number of threads map may use, by default one per hardware thread
+  std::size_t map_threads() const noexcept;
+
+  /*! Add a mapping from sym argument to the exp argument within this frame.
     \param sym the symbol to add
     \param exp the expression the symbol should map to
    */
@@ -102,17 +180,43 @@ private:
     EnvResultType type;
     Expression exp; // used when type is ExpressionType
     Procedure proc; // used when type is ProcedureType
+    std::uint64_t stamp; // process-wide unique per definition
 
     // constructors for use in container emplace
     EnvResult(){};
-    EnvResult(EnvResultType t, Expression e) : type(t), exp(e){};
-    EnvResult(EnvResultType t, Procedure p) : type(t), proc(p){};
+    EnvResult(EnvResultType t, Expression e);
+    EnvResult(EnvResultType t, Procedure p) : type(t), proc(p), stamp(0){};
   };
 
-  // the environment map
-  std::map<std::string, EnvResult> envmap;
-  std::map<std::string, EnvResult> localMap;
-  
+  // find the entry for sym in this frame or the nearest enclosing one
+  const EnvResult * lookup(const Atom &sym) const;
+
+  // find the position of sym in this frame only
+  bool find(const Atom &sym, std::size_t &index) const;
+
+  // bind sym in this frame, replacing any existing binding
+  void bind(const Atom &sym, EnvResult &&result);
+
+  // the bindings of this frame in definition order
+  std::vector<Atom> names;
+  std::vector<EnvResult> entries;
+
+  // global frame only: position in entries plus one by symbol id, zero
+  // when unbound
+  std::vector<std::size_t> slots;
+
+  // the enclosing frame, nullptr for the global environment
+  const Environment * parent;
+
+  // global frame only: the version, see version()
+  std::uint64_t version_stamp;
+
+  // global frame only: see auto_memoize()
+  bool memoize_lambdas;
+
+  // global frame only: see map_threads()
+  std::size_t map_thread_count;
+
 };
 
 #endif
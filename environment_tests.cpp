@@ -234,6 +234,40 @@ TEST_CASE( "Test get built-in procedure", "[environment]" ) {
   REQUIRE_THROWS_AS(conj(args12), SemanticError);
 }
 
+TEST_CASE( "Test arithmetic on real and complex arguments", "[environment]" ) {
+  Environment env;
+
+  typedef std::complex<double> C;
+  Procedure add = env.get_proc(Atom("+"));
+  Procedure mul = env.get_proc(Atom("*"));
+  Procedure sub = env.get_proc(Atom("-"));
+  Procedure div = env.get_proc(Atom("/"));
+
+  std::vector<Expression> reals = {Expression(1.), Expression(2.), Expression(4.)};
+  REQUIRE(add(reals) == Expression(7.));
+  REQUIRE(add(reals).isHeadNumber());
+  REQUIRE(mul(reals) == Expression(8.));
+  REQUIRE(mul(reals).isHeadNumber());
+  REQUIRE(mul({}) == Expression(1.));
+
+  std::vector<Expression> mixed = {Expression(1.), Expression(C(2, 1)), Expression(4.)};
+  REQUIRE(add(mixed) == Expression(C(7, 1)));
+  REQUIRE(mul(mixed) == Expression(C(8, 4)));
+
+  Expression two(2.), i(C(0, 1));
+  REQUIRE(sub({two}) == Expression(-2.));
+  REQUIRE(sub({i}) == Expression(C(0, -1)));
+  REQUIRE(sub({two, two}) == Expression(0.));
+  REQUIRE(sub({two, i}) == Expression(C(2, -1)));
+  REQUIRE(sub({i, two}) == Expression(C(-2, 1)));
+  REQUIRE(sub({i, i}) == Expression(C(0, 0)));
+  REQUIRE(div({two}) == Expression(0.5));
+  REQUIRE(div({two, two}) == Expression(1.));
+  REQUIRE(div({two, i}) == Expression(C(0, -2)));
+  REQUIRE(div({i, two}) == Expression(C(0, 0.5)));
+  REQUIRE(div({i, i}) == Expression(C(1, 0)));
+}
+
 TEST_CASE( "Test reset", "[environment]" ) {
   Environment env;
 
@@ -251,6 +285,64 @@ TEST_CASE( "Test reset", "[environment]" ) {
   REQUIRE(env.get_exp(Atom("hi")) == Expression());
 }
 
+TEST_CASE( "Test local frame", "[environment]" ) {
+  Environment env;
+  env.add_exp(Atom("one"), Expression(1.0));
+
+  Environment frame(&env);
+
+  INFO("lookups fall through to the parent");
+  REQUIRE(frame.is_exp(Atom("one")));
+  REQUIRE(frame.is_exp(Atom("pi")));
+  REQUIRE(frame.is_proc(Atom("+")));
+  REQUIRE(frame.get_exp(Atom("one")) == Expression(1.0));
+
+  INFO("definitions stay in the frame");
+  frame.add_exp(Atom("two"), Expression(2.0));
+  frame.add_exp(Atom("one"), Expression(11.0));
+  REQUIRE(frame.get_exp(Atom("two")) == Expression(2.0));
+  REQUIRE(frame.get_exp(Atom("one")) == Expression(11.0));
+  REQUIRE(!env.is_known(Atom("two")));
+  REQUIRE(env.get_exp(Atom("one")) == Expression(1.0));
+}
+
+TEST_CASE( "Test local frame slots", "[environment]" ) {
+  Environment env;
+  env.add_exp(Atom("x"), Expression(1.0));
+
+  Environment frame(&env);
+  frame.add_exp(Atom("x"), Expression(2.0));
+  frame.add_exp(Atom("y"), Expression(3.0));
+
+  INFO("bindings are addressed in definition order");
+  REQUIRE(frame.find_local(0, Atom("x")) != nullptr);
+  REQUIRE(*frame.find_local(0, Atom("x")) == Expression(2.0));
+  REQUIRE(*frame.find_local(1, Atom("y")) == Expression(3.0));
+
+  INFO("rebinding keeps the slot");
+  frame.add_exp(Atom("x"), Expression(4.0));
+  REQUIRE(*frame.find_local(0, Atom("x")) == Expression(4.0));
+
+  INFO("a slot holding another symbol, or out of range, is not found");
+  REQUIRE(frame.find_local(1, Atom("x")) == nullptr);
+  REQUIRE(frame.find_local(2, Atom("z")) == nullptr);
+
+  INFO("the global frame has no slots");
+  REQUIRE(env.find_local(0, Atom("x")) == nullptr);
+
+  Environment inner(&frame);
+  inner.add_exp(Atom("z"), Expression(5.0));
+
+  INFO("slots of enclosing frames are addressed by depth");
+  REQUIRE(*inner.find_local(1, Atom("y"), 1) == Expression(3.0));
+  REQUIRE(inner.find_local(0, Atom("y"), 1) == nullptr);
+  REQUIRE(inner.find_local(0, Atom("w"), 2) == nullptr);
+
+  INFO("a nearer binding hides the slot");
+  inner.add_exp(Atom("y"), Expression(6.0));
+  REQUIRE(*inner.find_local(1, Atom("y"), 1) == Expression(6.0));
+}
+
 TEST_CASE( "Test semeantic errors", "[environment]" ) {
 
   Environment env;
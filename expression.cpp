@@ -5,12 +5,18 @@
 
 #include <sstream>
 #include <list>
+#include <mutex>
+#include <utility>
 #include <vector>
 
 #include <iostream>
 
+#include "arena.hpp"
+#include "effects.hpp"
 #include "environment.hpp"
+#include "memo.hpp"
 #include "semantic_error.hpp"
+#include "worker_pool.hpp"
 
 const double N = 20;
 const double A = 3;
@@ -18,25 +24,69 @@ const double B = 3;
 const double C = 2;
 const double D = 2;
 const double P = 0.5;
+
+// lists shorter than this are mapped on the calling thread
+const std::size_t PARALLEL_MAP_MIN = 1024;
 const double PI = std::atan2(0, -1);
 
 
 
-Expression::Expression() {}
+// resolve the special form a head atom names, from a fixed table of
+// interned symbols so each entry is a pointer comparison
+static Expression::Form formOf(const Atom & a) {
+
+	struct FormEntry { Atom name; Expression::Form form; };
+	static const FormEntry forms[] = {
+		{ Atom("list"), Expression::ListForm },
+		{ Atom("apply"), Expression::ApplyForm },
+		{ Atom("begin"), Expression::BeginForm },
+		{ Atom("define"), Expression::DefineForm },
+		{ Atom("lambda"), Expression::LambdaForm },
+		{ Atom("map"), Expression::MapForm },
+		{ Atom("set-property"), Expression::SetPropertyForm },
+		{ Atom("get-property"), Expression::GetPropertyForm },
+		{ Atom("discrete-plot"), Expression::DiscretePlotForm },
+		{ Atom("continuous-plot"), Expression::ContinuousPlotForm },
+		{ Atom("memoize"), Expression::MemoizeForm },
+		{ Atom("memo-stats"), Expression::MemoStatsForm }
+	};
+
+	if (a.isSymbol()) {
+		for (auto & f : forms) {
+			if (a == f.name)
+				return f.form;
+		}
+	}
+	return Expression::NoForm;
+}
+
+Expression::Expression(): m_form(NoForm), m_effect(Mutating), m_slot(-1), m_depth(0) {}
 
 Expression::Expression(const Atom & a) {
 
 	m_head = a;
+	m_form = formOf(a);
+	m_effect = Mutating;
+	m_slot = -1;
+	m_depth = 0;
 }
 
-// recursive copy
+Expression::Expression(const Atom & head, std::vector<double> numbers)
+	: m_head(head), m_form(formOf(head)), m_effect(Mutating), m_slot(-1), m_depth(0),
+	  m_tail(std::move(numbers)) {}
+
+// shallow copy, the tail is shared until either copy changes it
 
 Expression::Expression(const Expression & a) {
 
 	m_head = a.m_head;
-	for (auto e : a.m_tail) {
-		m_tail.push_back(e);
-	}
+	m_form = a.m_form;
+	m_effect = a.m_effect;
+	m_slot = a.m_slot;
+	m_depth = a.m_depth;
+	m_cache = a.m_cache;
+	m_memo = a.m_memo;
+	m_tail = a.m_tail;
 	propertyList = a.propertyList;
 
 }
@@ -46,44 +96,286 @@ Expression & Expression::operator=(const Expression & a) {
 	// prevent self-assignment
 	if (this != &a) {
 		m_head = a.m_head;
-		m_tail.clear();
-		for (auto e : a.m_tail) {
-			m_tail.push_back(e);
-		}
+		m_form = a.m_form;
+		m_effect = a.m_effect;
+		m_slot = a.m_slot;
+		m_depth = a.m_depth;
+		m_cache = a.m_cache;
+		m_memo = a.m_memo;
+		m_tail = a.m_tail;
 		propertyList = a.propertyList;
 	}
 
 	return *this;
 }
 
+Expression::Expression(Expression && a) noexcept
+	: m_head(a.m_head), m_form(a.m_form), m_effect(a.m_effect), m_slot(a.m_slot),
+	  m_depth(a.m_depth), m_cache(std::move(a.m_cache)), m_memo(std::move(a.m_memo)),
+	  m_tail(std::move(a.m_tail)), propertyList(std::move(a.propertyList)) {
+
+	a.m_head = Atom();
+	a.m_form = NoForm;
+	a.m_effect = Mutating;
+	a.m_slot = -1;
+	a.m_depth = 0;
+}
+
+Expression & Expression::operator=(Expression && a) noexcept {
+
+	if (this != &a) {
+		m_head = a.m_head;
+		m_form = a.m_form;
+		m_effect = a.m_effect;
+		m_slot = a.m_slot;
+		m_depth = a.m_depth;
+		m_cache = std::move(a.m_cache);
+		m_memo = std::move(a.m_memo);
+		m_tail = std::move(a.m_tail);
+		propertyList = std::move(a.propertyList);
+
+		a.m_head = Atom();
+		a.m_form = NoForm;
+		a.m_effect = Mutating;
+		a.m_slot = -1;
+		a.m_depth = 0;
+	}
+
+	return *this;
+}
+
 
 Atom & Expression::head() {
 	return m_head;
 }
 
-const Atom & Expression::head() const {
-	return m_head;
+void Expression::setHead(const Atom & a) {
+	m_head = a;
+	m_form = formOf(a);
 }
 
-bool Expression::isHeadNumber() const noexcept {
-	return m_head.isNumber();
+Expression::Form Expression::form() const noexcept {
+	return m_form;
+}
+
+Expression::Effect Expression::effect() const noexcept {
+	return m_effect;
+}
+
+const std::vector<double> * Expression::packedNumbers() const noexcept {
+	return m_tail.numbers();
+}
+
+bool Expression::isBareNumber() const noexcept {
+	return m_head.isNumber() && m_tail.empty() && (propertyList.size() == 0);
 }
 
 bool Expression::isHeadSymbol() const noexcept {
 	return m_head.isSymbol();
 }
 
-bool Expression::isHeadComplex() const noexcept
-{
-	return m_head.isComplex();
+struct Expression::Tail::Block {
+	std::atomic<std::size_t> refs;
+	std::vector<Expression> items;
+	NodeArena::Chunk * chunk; // nullptr when allocated on the heap
+
+	// a packed list of numbers keeps them here, and expands them into
+	// items only when an element is first needed as an Expression
+	bool packed;
+	std::vector<double> numbers;
+	std::once_flag expanded;
+
+	Block(): refs(1), chunk(nullptr), packed(false) {}
+	Block(const std::vector<Expression> & v): refs(1), items(v), chunk(nullptr), packed(false) {}
+	Block(std::vector<double> && v): refs(1), chunk(nullptr), packed(true), numbers(std::move(v)) {}
+
+	// the elements as expressions, valid for a packed block too
+	const std::vector<Expression> & view() {
+		if (packed) {
+			std::call_once(expanded, [this]() {
+				items.reserve(numbers.size());
+				for (double n : numbers)
+					items.emplace_back(Atom(n));
+			});
+		}
+		return items;
+	}
+
+	// a new empty block, from the current arena if there is one
+	static Block * create() {
+		NodeArena * arena = NodeArena::current();
+		if (arena == nullptr)
+			return new Block();
+
+		NodeArena::Chunk * owner = nullptr;
+		Block * block = new (arena->allocate(sizeof(Block), owner)) Block();
+		block->chunk = owner;
+		return block;
+	}
+
+	static void destroy(Block * block) noexcept {
+		NodeArena::Chunk * owner = block->chunk;
+		if (owner == nullptr) {
+			delete block;
+			return;
+		}
+		block->~Block();
+		NodeArena::free(owner);
+	}
+};
+
+Expression::Tail::Tail() noexcept: block(nullptr) {}
+
+Expression::Tail::Tail(const Tail & other) noexcept: block(other.block) {
+	if (block != nullptr)
+		block->refs.fetch_add(1, std::memory_order_relaxed);
 }
 
-bool Expression::map_contains(std::string key)
-{
-	if (parameter_list.find(key) == parameter_list.cend())
-		return false;
-	else
-		return true;
+Expression::Tail & Expression::Tail::operator=(const Tail & other) noexcept {
+	Tail copy(other);
+	std::swap(block, copy.block);
+	return *this;
+}
+
+Expression::Tail::Tail(std::vector<double> && numbers): block(nullptr) {
+	if (!numbers.empty())
+		block = new Block(std::move(numbers));
+}
+
+Expression::Tail::Tail(Tail && other) noexcept: block(other.block) {
+	other.block = nullptr;
+}
+
+Expression::Tail & Expression::Tail::operator=(Tail && other) noexcept {
+	Tail moved(std::move(other));
+	std::swap(block, moved.block);
+	return *this;
+}
+
+Expression::Tail::~Tail() {
+	if (block != nullptr && block->refs.fetch_sub(1, std::memory_order_acq_rel) == 1)
+		Block::destroy(block);
+}
+
+std::size_t Expression::Tail::size() const noexcept {
+	if (block == nullptr)
+		return 0;
+	return block->packed ? block->numbers.size() : block->items.size();
+}
+
+bool Expression::Tail::empty() const noexcept {
+	return size() == 0;
+}
+
+const Expression & Expression::Tail::operator[](std::size_t i) const {
+	return block->view()[i];
+}
+
+// every empty tail iterates over the same empty vector, which is never
+// changed, so iterating does not allocate a block
+static std::vector<Expression> & noItems() {
+	static std::vector<Expression> none;
+	return none;
+}
+
+Expression::ConstIteratorType Expression::Tail::begin() const noexcept {
+	return block == nullptr ? noItems().cbegin() : block->view().cbegin();
+}
+
+Expression::ConstIteratorType Expression::Tail::end() const noexcept {
+	return block == nullptr ? noItems().cend() : block->view().cend();
+}
+
+std::vector<Expression> & Expression::Tail::items() {
+	if (block == nullptr) {
+		block = Block::create();
+	}
+	else if (block->refs.load(std::memory_order_acquire) != 1) {
+		// copy on write, the children themselves stay shared
+		Block * copy = new Block(block->view());
+		Tail old;
+		old.block = block;
+		block = copy;
+	}
+	else if (block->packed) {
+		// unshared, so it can stop being packed in place
+		block->view();
+		block->packed = false;
+		std::vector<double>().swap(block->numbers);
+	}
+	return block->items;
+}
+
+const std::vector<double> * Expression::Tail::numbers() const noexcept {
+	return (block != nullptr && block->packed) ? &block->numbers : nullptr;
+}
+
+Expression & Expression::Tail::operator[](std::size_t i) {
+	return items()[i];
+}
+
+Expression::IteratorType Expression::Tail::begin() {
+	return block == nullptr ? noItems().begin() : items().begin();
+}
+
+Expression::IteratorType Expression::Tail::end() {
+	return block == nullptr ? noItems().end() : items().end();
+}
+
+Expression & Expression::Tail::back() {
+	return items().back();
+}
+
+void Expression::Tail::push_back(const Expression & e) {
+	items().push_back(e);
+}
+
+void Expression::Tail::push_back(Expression && e) {
+	items().push_back(std::move(e));
+}
+
+void Expression::Tail::emplace_back(const Atom & a) {
+	items().emplace_back(a);
+}
+
+void Expression::Tail::reserve(std::size_t n) {
+	if (n > 0)
+		items().reserve(n);
+}
+
+void Expression::Tail::clear() noexcept {
+	Tail none;
+	std::swap(block, none.block);
+}
+
+// every expression without properties iterates over the same empty map
+const Expression::Properties::Map & Expression::Properties::none() {
+	static const Map empty;
+	return empty;
+}
+
+std::size_t Expression::Properties::size() const noexcept {
+	return block ? block->size() : 0;
+}
+
+Expression::Properties::Map::const_iterator Expression::Properties::begin() const noexcept {
+	return block ? block->cbegin() : none().cbegin();
+}
+
+Expression::Properties::Map::const_iterator Expression::Properties::end() const noexcept {
+	return block ? block->cend() : none().cend();
+}
+
+Expression::Properties::Map::const_iterator Expression::Properties::find(const std::string & key) const {
+	return block ? block->find(key) : none().cend();
+}
+
+Expression & Expression::Properties::operator[](const std::string & key) {
+	if (!block)
+		block = std::make_shared<Map>();
+	else if (block.use_count() != 1)
+		block = std::make_shared<Map>(*block);
+	return (*block)[key];
 }
 
 void Expression::append(const Atom & a) {
@@ -94,6 +386,14 @@ void Expression::appendExpression(const Expression & a) {
 	m_tail.push_back(a);
 }
 
+void Expression::appendExpression(Expression && a) {
+	m_tail.push_back(std::move(a));
+}
+
+void Expression::reserve(std::size_t n) {
+	m_tail.reserve(n);
+}
+
 
 Expression * Expression::tail() {
 	Expression * ptr = nullptr;
@@ -106,20 +406,15 @@ Expression * Expression::tail() {
 }
 
 Expression::ConstIteratorType Expression::tailConstBegin() const noexcept {
-	return m_tail.cbegin();
+	return m_tail.begin();
 }
 
 Expression::ConstIteratorType Expression::tailConstEnd() const noexcept {
-	return m_tail.cend();
+	return m_tail.end();
 }
 
 //bool Expression::isList()
 Expression apply(const Atom & op, const std::vector<Expression> & args, const Environment & env) {
-	Environment lambdaEnv = env;
-	Expression exp;
-
-
-
 
 	// head must be a symbol
 	if (!op.isSymbol()) {
@@ -138,18 +433,24 @@ Expression apply(const Atom & op, const std::vector<Expression> & args, const En
 	return proc(args);
 }
 
-Expression Expression::handle_lookup(const Atom & head, const Environment & env) {
+Expression Expression::handle_lookup(const Atom & head, const Environment & env) const {
 
 	//this;
 
 
 	if (head.isSymbol() && head.asSymbol().at(0) != '"') { // if symbol is in env return value
-		if (env.is_exp(head)) {
-			return env.get_exp(head);
+		if (m_slot >= 0) { // a lambda parameter, read it from its call frame by position
+			const Expression * local = env.find_local(m_slot, head, m_depth);
+			if (local != nullptr) {
+				return *local;
+			}
 		}
-		else {
+		std::uint64_t stamp = 0;
+		const Expression * exp = env.find_exp(head, stamp);
+		if (exp == nullptr) {
 			throw SemanticError("Error during evaluation: unknown symbol");
 		}
+		return *exp;
 	}
 	else if (head.isNumber() || head.isComplex() || head.asSymbol().at(0) == '"') {
 		return Expression(head);
@@ -159,20 +460,20 @@ Expression Expression::handle_lookup(const Atom & head, const Environment & env)
 	}
 }
 
-Expression Expression::handle_begin(Environment & env) {
+Expression Expression::handle_begin(Environment & env) const {
 
 	if (m_tail.size() == 0) {
 		throw SemanticError("Error during evaluation: zero arguments to begin");
 	}
 	// evaluate each arg from tail, return the last
 	Expression result;
-	for (Expression::IteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
+	for (Expression::ConstIteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
 		result = it->eval(env);
 	}
 	return result;
 }
 
-Expression Expression::handle_lambda(Environment & env)
+Expression Expression::handle_lambda(Environment & env) const
 {
 	if (m_tail.size() != 2)
 		throw SemanticError("Error during lambda evaluation: invalid number of arguments");
@@ -184,8 +485,29 @@ Expression Expression::handle_lambda(Environment & env)
 	for (unsigned int i = 0; i < result.m_tail[0].m_tail.size(); i++) {
 		list.emplace_back(result.m_tail[0].m_tail[i]);
 	}
+	// parameters are bound as define binds, so they may not shadow a
+	// procedure or a special form. With no procedure shadowed, a call to one
+	// always reaches the builtin, which both engines rely on.
+	for (auto & p : list) {
+		if (env.is_proc(p.m_head))
+			throw SemanticError("Error: attempt to redefine procedure");
+		if ((p.m_form == DefineForm) || (p.m_form == BeginForm))
+			throw SemanticError("Error during evaluation: attempt to redefine a special-form");
+	}
 	myList = listFunction(list);
-	result.m_tail[0] = myList;
+	result.m_tail[0] = std::move(myList);
+	if (result.m_slot < 0) {
+		std::vector<std::vector<Atom> > scopes(1);
+		for (auto & p : result.m_tail[0].m_tail)
+			scopes[0].push_back(p.m_head);
+		result.m_tail[1].resolve(scopes);
+		result.m_slot = 0;
+	}
+
+	std::vector<Atom> procs;
+	result.m_effect = analyze_effects(result, env, procs);
+	if (env.auto_memoize() && result.m_effect == Pure)
+		result.m_memo = std::make_shared<MemoTable>(MEMO_CAPACITY, procs);
 	env.is_known(m_head);
 	//if (result.m_tail[0].head().asSymbol() != "list")
 	//throw SemanticError("Error during lambda evaluation: first argument not a list");
@@ -194,7 +516,90 @@ Expression Expression::handle_lambda(Environment & env)
 }
 
 
-Expression Expression::handle_define(Environment & env) {
+// address references to the parameters of a lambda, and of the lambdas
+// enclosing it, by the depth of their call frame and their slot in it.
+// scopes holds the parameters of each enclosing lambda, innermost last.
+// Scoping is dynamic, so the frame at a depth is only the one expected when
+// the lambda is called from the body of the one enclosing it; find_local
+// checks the frames it passes and falls back to lookup by name otherwise.
+// A nested lambda is resolved here with its body, and not again when it is
+// evaluated.
+void Expression::resolve(std::vector<std::vector<Atom> > & scopes)
+{
+	if (m_form == LambdaForm) {
+		if (m_slot >= 0 || m_tail.size() != 2)
+			return;
+		std::vector<Atom> params(1, m_tail[0].m_head);
+		for (auto & p : m_tail[0].m_tail)
+			params.push_back(p.m_head);
+		scopes.push_back(std::move(params));
+		m_tail[1].resolve(scopes);
+		scopes.pop_back();
+		m_slot = 0;
+		return;
+	}
+
+	m_slot = -1;
+	m_depth = 0;
+	if (m_tail.empty() && m_head.isSymbol() && m_form != ListForm) {
+		for (std::size_t d = 0; d < scopes.size() && m_slot < 0; d++) {
+			const std::vector<Atom> & params = scopes[scopes.size() - 1 - d];
+			for (std::size_t i = 0; i < params.size(); i++) {
+				if (params[i] == m_head) {
+					m_slot = static_cast<int>(i);
+					m_depth = static_cast<int>(d);
+					break;
+				}
+			}
+		}
+	}
+	else if ((m_form == ListForm || (m_form == NoForm && !m_tail.empty())) && !m_cache) {
+		// a call site, give it a cache every copy of the lambda shares. It
+		// is made here, before the lambda can be called, since the workers
+		// of a parallel map evaluate the same body nodes
+		m_cache = std::make_shared<CallCache>();
+	}
+	for (auto & e : m_tail) {
+		e.resolve(scopes);
+	}
+}
+
+static bool hasDefine(const Expression & exp)
+{
+	if (exp.form() == Expression::DefineForm)
+		return true;
+	for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e) {
+		if (hasDefine(*e))
+			return true;
+	}
+	return false;
+}
+
+// resolve the head of a call in the global frame and remember the result.
+// Call sites in a lambda body get their cache from resolve, so only nodes
+// that a single thread evaluates create one here.
+void Expression::cache_call(const Environment & env) const
+{
+	if (!m_cache)
+		m_cache = std::make_shared<CallCache>();
+
+	std::uint64_t stamp = 0;
+	const Expression * exp = env.find_exp(m_head, stamp);
+
+	bool defines = false;
+	for (auto & e : m_tail) {
+		defines = defines || hasDefine(e);
+	}
+
+	m_cache->lambda.store((exp != nullptr && exp->m_form == LambdaForm) ? exp : nullptr,
+		std::memory_order_relaxed);
+	m_cache->proc.store(env.is_proc(m_head) ? env.get_proc(m_head) : nullptr,
+		std::memory_order_relaxed);
+	m_cache->defines.store(defines, std::memory_order_relaxed);
+	m_cache->version.store(env.version(), std::memory_order_release);
+}
+
+Expression Expression::handle_define(Environment & env) const {
 
 	// tail must have size 3 or error
 	if (m_tail.size() != 2) {
@@ -206,8 +611,7 @@ Expression Expression::handle_define(Environment & env) {
 	}
 	if (env.is_proc(m_tail[0].m_head))
 		throw SemanticError("Error: attempt to redefine procedure");
-	std::string s = m_tail[0].head().asSymbol();
-	if ((s == "define") || (s == "begin")) {
+	if ((m_tail[0].m_form == DefineForm) || (m_tail[0].m_form == BeginForm)) {
 		throw SemanticError("Error during evaluation: attempt to redefine a special-form");
 	}
 	if (env.is_proc(m_head)) {
@@ -219,7 +623,7 @@ Expression Expression::handle_define(Environment & env) {
 	return result;
 }
 
-Expression Expression::doApply(Environment& env)
+Expression Expression::doApply(Environment& env) const
 {
 	Expression exp = env.get_exp(m_tail[0].m_head);
 	Expression result;
@@ -228,7 +632,7 @@ Expression Expression::doApply(Environment& env)
 		throw SemanticError("Error in call to apply: incorrect number of arguments");
 	if (m_tail[0].m_tail.size() != 0 || !env.is_known(m_tail[0].m_head))
 		throw SemanticError("Error in call to apply: first argument not a procedure");
-	if (m_tail[1].head().asSymbol() != "list")
+	if (m_tail[1].m_form != ListForm)
 		throw SemanticError("Error in call to apply: second argument not a list");
 	if (env.is_proc(m_tail[0].m_head))
 	{
@@ -240,7 +644,7 @@ Expression Expression::doApply(Environment& env)
 	}
 	else if (env.is_exp(m_tail[0].m_head))
 	{
-		if (exp.head().asSymbol() == "lambda")
+		if (exp.m_form == LambdaForm)
 		{
 			Expression branchEval(m_tail[1]);
 			Expression evalList = branchEval.eval(env);
@@ -255,67 +659,207 @@ Expression Expression::doApply(Environment& env)
 	return result;
 }
 
-Expression Expression::doMap(Environment& env, Environment& lambdaEnv) {
+// the values of a map by index, which may be set concurrently. Numbers are
+// kept unboxed, so a list of them is packed without making a node for each.
+class MapValues {
+public:
+	explicit MapValues(std::size_t count) : numbers(count), others(count) {}
+
+	void set(std::size_t i, Expression && value) {
+		if (value.isBareNumber())
+			numbers[i] = value.head().asNumber();
+		else
+			others[i].reset(new Expression(std::move(value)));
+	}
+
+	Expression list() {
+		Atom HEAD("list");
+		bool packed = !numbers.empty();
+		for (auto & o : others)
+			packed = packed && !o;
+		if (packed)
+			return Expression(HEAD, std::move(numbers));
+
+		Expression result(HEAD);
+		result.reserve(numbers.size());
+		for (std::size_t i = 0; i < numbers.size(); i++) {
+			if (others[i])
+				result.appendExpression(std::move(*others[i]));
+			else
+				result.append(Atom(numbers[i]));
+		}
+		return result;
+	}
+
+private:
+	std::vector<double> numbers;
+	std::vector<std::unique_ptr<Expression> > others;
+};
+
+Expression Expression::doMap(Environment& env) const {
 	//Expression exp = env.get_exp(m_tail[0].m_head);
 
 	Expression result;
-	Expression check_list = m_tail[1].eval(env);
+	// read only, the workers of a parallel map share it
+	const Expression check_list = m_tail[1].eval(env);
 	if (m_tail.size() != 2)
 		throw SemanticError("Error in call for map: incorrect number of arguments");
 	//if (!env.is_proc(m_tail[0].m_head))
 	// throw SemanticError("Error in call for map: first argument not a procedure");
 	if (m_tail[0].m_tail.size() != 0 || m_tail[0].m_head.isNumber())
 		throw SemanticError("Error incall for map: first argument not a procedure");
-	if (check_list.m_head.asSymbol() != "list")
+	if (check_list.m_form != ListForm)
 		throw SemanticError("Error in call for map: second argument not a list");
 	Expression exp = env.get_exp(m_tail[0].m_head);
 
+	// the elements of a packed list are made as needed rather than expanding
+	// the whole list
+	const std::vector<double> * packed = check_list.packedNumbers();
+	auto element = [&](std::size_t i) {
+		return packed != nullptr ? Expression(Atom((*packed)[i])) : check_list.m_tail[i];
+	};
+
 	if (env.is_proc(m_tail[0].m_head))
 	{
-		Expression mapList(Atom("list"));
+		MapValues mapList(check_list.m_tail.size());
 		for (unsigned int i = 0; i < check_list.m_tail.size(); i++)
 		{
 			Expression mapExp(m_tail[0].m_head);
-			mapExp.appendExpression(check_list.m_tail[i]);
-			mapList.appendExpression(mapExp.eval(env));
+			mapExp.appendExpression(element(i));
+			mapList.set(i, mapExp.eval(env));
 
 		}
-		result = mapList;
+		result = mapList.list();
 	}
 	else if (env.is_exp(m_tail[0].m_head))
 	{
-		Expression mapLambda(Atom("list"));
-		if (exp.head().asSymbol() == "lambda")
+		if (exp.m_form == LambdaForm)
 		{
-			//Expression mapLambda;
-			for (unsigned int i = 0; i < check_list.m_tail.size(); i++) {
+			std::size_t count = check_list.m_tail.size();
+			MapValues values(count);
+			auto mapElement = [&](std::size_t i) {
 				Expression lambdaMapTree(m_tail[0].m_head);
-				lambdaMapTree.appendExpression(check_list.m_tail[i]);
-				mapLambda.appendExpression(lambdaMapTree.eval(lambdaEnv));
-
+				lambdaMapTree.appendExpression(element(i));
+				values.set(i, lambdaMapTree.eval(env));
+			};
+
+			// a lambda that does not mutate only reads the environment while
+			// it runs, so a large list is split across the worker pool
+			std::size_t threads = env.map_threads();
+			if (threads > 1 && count >= PARALLEL_MAP_MIN && !WorkerPool::in_worker() &&
+				exp.m_effect != Mutating) {
+				WorkerPool::shared().reserve(threads - 1);
+				parallel_for(count, threads, mapElement);
+			}
+			else {
+				for (std::size_t i = 0; i < count; i++)
+					mapElement(i);
 			}
-			result = mapLambda;
+
+			result = values.list();
 
 		}
 	}
 	return result;
 }
 
-Expression Expression::doLambda(Environment & lambdaEnv, Environment & env, Expression check)
+Expression Expression::doLambda(Environment & env, const Expression & lambda) const
 {
+	const Expression & params = lambda.m_tail[0];
+	if (m_tail.size() != params.m_tail.size())
+		throw SemanticError("Error in call to lambda: incorrect number of arguments");
+
+	// arguments are evaluated in the caller's scope
+	std::vector<Expression> args;
 	for (unsigned int i = 0; i < m_tail.size(); i++)
 	{
-		Expression exp(Atom("define"));
-		exp.appendExpression(check.m_tail[0].m_tail[i]);
-		exp.appendExpression(m_tail[i]);
-		exp.eval(lambdaEnv);
-		env.is_known(m_head);
+		args.push_back(m_tail[i].eval(env));
 	}
-	Expression LAMBDA(check.m_tail[1]);
-	return LAMBDA.eval(lambdaEnv);
+	return lambda.call(env, args);
 }
 
-Expression Expression::doSetProperty(Environment& env)
+Expression Expression::call(Environment & env, const std::vector<Expression> & args) const
+{
+	const Expression & params = m_tail[0];
+	if (args.size() != params.m_tail.size())
+		throw SemanticError("Error in call to lambda: incorrect number of arguments");
+
+	// the memo answers unless a local frame shadows a procedure the body
+	// calls, which would change what the body computes
+	bool memoized = (m_memo != nullptr);
+	if (memoized) {
+		for (auto & p : m_memo->procedures())
+			memoized = memoized && !env.is_local(p);
+	}
+
+	Expression result;
+	if (memoized && m_memo->find(args, result))
+		return result;
+
+	// the parameters are bound in a fresh frame that lives only for the
+	// duration of this call. It is chained to the caller's environment:
+	// scoping is dynamic, see Environment
+	Environment frame(&env);
+	for (unsigned int i = 0; i < args.size(); i++)
+	{
+		frame.add_exp(params.m_tail[i].head(), args[i]);
+	}
+	result = m_tail[1].eval(frame);
+
+	if (memoized)
+		m_memo->insert(args, result);
+	return result;
+}
+
+const MemoTable * Expression::memo() const noexcept
+{
+	return m_memo.get();
+}
+
+int Expression::slot() const noexcept
+{
+	return m_slot;
+}
+
+int Expression::depth() const noexcept
+{
+	return m_depth;
+}
+
+Expression Expression::handle_memoize(Environment & env) const
+{
+	if (m_tail.size() != 1)
+		throw SemanticError("Error in call to memoize: incorrect number of arguments");
+
+	Expression result = m_tail[0].eval(env);
+	if (result.m_form != LambdaForm)
+		throw SemanticError("Error in call to memoize: argument not a lambda");
+
+	std::vector<Atom> procs;
+	if (analyze_effects(result, env, procs) != Pure)
+		throw SemanticError("Error in call to memoize: lambda is not pure");
+
+	result.m_memo = std::make_shared<MemoTable>(MEMO_CAPACITY, procs);
+	return result;
+}
+
+Expression Expression::handle_memo_stats(Environment & env) const
+{
+	if (m_tail.size() != 1)
+		throw SemanticError("Error in call to memo-stats: incorrect number of arguments");
+
+	Expression lambda = m_tail[0].eval(env);
+	if (!lambda.m_memo)
+		throw SemanticError("Error in call to memo-stats: argument not a memoized lambda");
+
+	// (hits misses)
+	Expression result(Atom("list"));
+	result.append(Atom(static_cast<double>(lambda.m_memo->hits())));
+	result.append(Atom(static_cast<double>(lambda.m_memo->misses())));
+	return result;
+}
+
+Expression Expression::doSetProperty(Environment& env) const
 {
 
 	if (m_tail[0].isHeadSymbol() && m_tail[0].head().asSymbol().at(0) != '"')
@@ -332,7 +876,7 @@ Expression Expression::doSetProperty(Environment& env)
 	return hasproperty;
 }
 
-Expression Expression::doGetProperty(Environment & env)
+Expression Expression::doGetProperty(Environment & env) const
 {
 
 	//Environment envi = env;
@@ -343,24 +887,22 @@ Expression Expression::doGetProperty(Environment & env)
 	Expression propName = m_tail[0];
 	Expression propLoc = env.get_exp(m_tail[1].head());
 
-	Expression hasProperty = propLoc.propertyList[propName.head().asSymbol()];
-	return hasProperty;
+	return propLoc.getProperty(propName.head().asSymbol());
 }
-Expression Expression::make_plot_bound(Environment &env, Expression origin_head, Expression &output)
+Expression Expression::make_plot_bound(Expression origin_head, Expression &output, const PlotBounds & bounds) const
 {
-	Environment envi = env;
 	Expression org = origin_head;
 	Expression bound(Atom("list"));
 	Expression objectname(Atom("\"object-name\""));
 	Expression propnamepoint(Atom("\"point\""));
 	Expression propnameline(Atom("\"line\""));
 
-	double x_min = min_max_list["x_min"];
-	double x_max = min_max_list["x_max"];
-	double y_min = min_max_list["y_min"];
-	double y_max = min_max_list["y_max"];
-	double x_scale = min_max_list["x_scale"];
-	double y_scale = min_max_list["y_scale"];
+	double x_min = bounds.x_min;
+	double x_max = bounds.x_max;
+	double y_min = bounds.y_min;
+	double y_max = bounds.y_max;
+	double x_scale = bounds.x_scale;
+	double y_scale = bounds.y_scale;
 
 	//bottom left point coords
 	Expression bottom_left_x(Atom(x_scale * x_min));
@@ -438,7 +980,7 @@ Expression Expression::make_plot_bound(Environment &env, Expression origin_head,
 	return bound;
 }
 
-void Expression::get_min_max(Expression tail_0, Expression tail_1)
+void Expression::get_min_max(Expression tail_0, Expression tail_1, PlotBounds & bounds) const
 {
 	/*Expression min_x(Atom("x_min"));
 	Expression max_x(Atom("x_max"));
@@ -466,17 +1008,17 @@ void Expression::get_min_max(Expression tail_0, Expression tail_1)
 		}
 
 
-		min_max_list["x_min"] = x_min;
-		min_max_list["x_max"] = x_max;
-		min_max_list["y_min"] = y_min;
-		min_max_list["y_max"] = y_max;
-		min_max_list["x_scale"] = 20.0 / (x_max - x_min);
-		min_max_list["y_scale"] = 20.0 / (y_max - y_min);
+		bounds.x_min = x_min;
+		bounds.x_max = x_max;
+		bounds.y_min = y_min;
+		bounds.y_max = y_max;
+		bounds.x_scale = 20.0 / (x_max - x_min);
+		bounds.y_scale = 20.0 / (y_max - y_min);
 
 	/*std::cout << "xmin: " << x_min << " xmax: " << x_max << " ymin: "
 	<< y_min << " ymax: " << y_max;*/
 }
-Expression Expression::get_labels(Expression tail_1, Expression & output, int plot)
+Expression Expression::get_labels(Expression tail_1, Expression & output, int plot, const PlotBounds & bounds) const
 {
 	Expression lab;
 	//int p = plot;
@@ -484,12 +1026,12 @@ Expression Expression::get_labels(Expression tail_1, Expression & output, int pl
 	Expression ex(plot);
 	Expression objectname(Atom("\"object-name\""));
 	Expression propnametext(Atom("\"text\""));
-	double x_min = min_max_list["x_min"];
-	double x_max = min_max_list["x_max"];
-	double y_min = min_max_list["y_min"];
-	double y_max = min_max_list["y_max"];
-	double x_scale = min_max_list["x_scale"];
-	double y_scale = min_max_list["y_scale"];
+	double x_min = bounds.x_min;
+	double x_max = bounds.x_max;
+	double y_min = bounds.y_min;
+	double y_max = bounds.y_max;
+	double x_scale = bounds.x_scale;
+	double y_scale = bounds.y_scale;
 
 
 	Expression objectposition(Atom("\"position\""));
@@ -668,19 +1210,18 @@ Expression Expression::get_labels(Expression tail_1, Expression & output, int pl
 	
 	return lab;
 }
-Expression Expression::make_plot_coords(Environment &env, Expression origin_head, bool y_overlap, bool x_overlap, Expression &output)
+Expression Expression::make_plot_coords(Expression origin_head, bool y_overlap, bool x_overlap, Expression &output, const PlotBounds & bounds) const
 {
 	Expression coords(Atom("list"));
 	Expression objectname(Atom("\"object-name\""));
 	Expression propnamepoint(Atom("\"point\""));
 	Expression propnameline(Atom("\"line\""));
-	Environment en = env;
-	double x_min = min_max_list["x_min"];
-	double x_max = min_max_list["x_max"];
-	double y_min = min_max_list["y_min"];
-	double y_max = min_max_list["y_max"];
-	double x_scale = min_max_list["x_scale"];
-	double y_scale = min_max_list["y_scale"];
+	double x_min = bounds.x_min;
+	double x_max = bounds.x_max;
+	double y_min = bounds.y_min;
+	double y_max = bounds.y_max;
+	double x_scale = bounds.x_scale;
+	double y_scale = bounds.y_scale;
 
 	Expression e = origin_head;
 	//bottom point coords
@@ -751,7 +1292,7 @@ Expression Expression::make_plot_coords(Environment &env, Expression origin_head
 
 	return coords;
 }
-Expression Expression::plot_data(Environment & env, Expression tail_0, Expression & output, bool x_overlap, int plot)
+Expression Expression::plot_data(Expression tail_0, Expression & output, bool x_overlap, int plot, const PlotBounds & bounds) const
 {
 	//int p_size = P;
 	Expression data_points(Atom("list"));
@@ -763,13 +1304,12 @@ Expression Expression::plot_data(Environment & env, Expression tail_0, Expressio
 	//double p_size = P;
 	Expression thickness(Atom(0));
 
-	//double x_min = min_max_list["x_min"];
-	//double x_max = min_max_list["x_max"];
-	double y_min = min_max_list["y_min"];
-	double y_max = min_max_list["y_max"];
-	double x_scale = min_max_list["x_scale"];
-	double y_scale = min_max_list["y_scale"];
-	Environment e = env;
+	//double x_min = bounds.x_min;
+	//double x_max = bounds.x_max;
+	double y_min = bounds.y_min;
+	double y_max = bounds.y_max;
+	double x_scale = bounds.x_scale;
+	double y_scale = bounds.y_scale;
 	Expression size;
 
 	if (plot == 0)
@@ -882,11 +1422,11 @@ Expression Expression::plot_data(Environment & env, Expression tail_0, Expressio
 
 	return output;
 }
-Expression Expression::do_discrete_plot(Environment & env)
+Expression Expression::do_discrete_plot(Environment & env) const
 {
 	if (m_tail.size() != 2)
 		throw SemanticError("Error: incorrect number of arguments in call to discrete-plot");
-	if (m_tail[1].head().asSymbol() != "list")
+	if (m_tail[1].m_form != ListForm)
 		throw SemanticError("Error: second argument in call to discrete-plot not a list");
 
 	Expression origin_head = *this;
@@ -898,14 +1438,15 @@ Expression Expression::do_discrete_plot(Environment & env)
 	if (m_tail[1].m_tail.size() != 0)
 		tail_1 = m_tail[1].eval(env);
 
-	get_min_max(tail_0, tail_1);
+	PlotBounds bounds;
+	get_min_max(tail_0, tail_1, bounds);
 
 	bool y_overlap = true;
 	bool x_overlap = true;
-	double x_min = min_max_list["x_min"];
-	double x_max = min_max_list["x_max"];
-	double y_min = min_max_list["y_min"];
-	double y_max = min_max_list["y_max"];
+	double x_min = bounds.x_min;
+	double x_max = bounds.x_max;
+	double y_min = bounds.y_min;
+	double y_max = bounds.y_max;
 	if (x_min > 0 || x_max < 0)
 		y_overlap = false;
 	if (y_min > 0 || y_max < 0)
@@ -913,10 +1454,10 @@ Expression Expression::do_discrete_plot(Environment & env)
 
 
 
-	plot_data(env, tail_0, output, x_overlap, 0);
-	make_plot_coords(env, origin_head, y_overlap, x_overlap, output);
-	make_plot_bound(env, origin_head, output);
-	get_labels(tail_1, output, 0);
+	plot_data(tail_0, output, x_overlap, 0, bounds);
+	make_plot_coords(origin_head, y_overlap, x_overlap, output, bounds);
+	make_plot_bound(origin_head, output, bounds);
+	get_labels(tail_1, output, 0, bounds);
 
 	//make_plot_labels(env, origin_head);
 	//output.appendExpression(exp);
@@ -928,7 +1469,7 @@ Expression Expression::do_discrete_plot(Environment & env)
 
 	return output;
 }
-Expression Expression::create_data_pairs(Expression tail_1, Environment & env)
+Expression Expression::create_data_pairs(Expression tail_1, Environment & env) const
 {
 	Expression data_pairs(Atom("list"));
 	double xmin = tail_1.m_tail[0].head().asNumber();
@@ -967,13 +1508,13 @@ Expression Expression::create_data_pairs(Expression tail_1, Environment & env)
 }
 
 
-Expression Expression::do_continuous_plot(Environment & env)
+Expression Expression::do_continuous_plot(Environment & env) const
 {
 	if (m_tail.size() != 2 && m_tail.size() != 3)
 		throw SemanticError("Error: incorrect number of arguments in call to continuous-plot");
-	if (m_tail[1].head().asSymbol() != "list")
+	if (m_tail[1].m_form != ListForm)
 		throw SemanticError("Error: second argument in call to continuous-plot not a list");
-	if (m_tail.size() == 3 && m_tail[2].head().asSymbol() != "list")
+	if (m_tail.size() == 3 && m_tail[2].m_form != ListForm)
 		throw SemanticError("Error: third argument in call to continuous-plot not a list");
 
 	Expression origin_head = *this;
@@ -989,7 +1530,8 @@ Expression Expression::do_continuous_plot(Environment & env)
 
 	Expression data = create_data_pairs(tail_1, env);
 	
-	get_min_max(data, tail_1);
+	PlotBounds bounds;
+	get_min_max(data, tail_1, bounds);
 
 	//std::cout << data;
 	//return data;
@@ -1007,10 +1549,10 @@ Expression Expression::do_continuous_plot(Environment & env)
 
 	bool y_overlap = true;
 	bool x_overlap = true;
-	double x_min = min_max_list["x_min"];
-	double x_max = min_max_list["x_max"];
-	double y_min = min_max_list["y_min"];
-	double y_max = min_max_list["y_max"];
+	double x_min = bounds.x_min;
+	double x_max = bounds.x_max;
+	double y_min = bounds.y_min;
+	double y_max = bounds.y_max;
 	if (x_min > 0 || x_max < 0)
 		y_overlap = false;
 	if (y_min > 0 || y_max < 0)
@@ -1018,10 +1560,10 @@ Expression Expression::do_continuous_plot(Environment & env)
 
 
 
-	plot_data(env, data, output, x_overlap, 1);
-	make_plot_coords(env, origin_head, y_overlap, x_overlap, output);
-	make_plot_bound(env, origin_head, output);
-	get_labels(tail_2, output, 1);
+	plot_data(data, output, x_overlap, 1, bounds);
+	make_plot_coords(origin_head, y_overlap, x_overlap, output, bounds);
+	make_plot_bound(origin_head, output, bounds);
+	get_labels(tail_2, output, 1, bounds);
 
 	//make_plot_labels(env, origin_head);
 	//output.appendExpression(exp);
@@ -1036,83 +1578,97 @@ Expression Expression::do_continuous_plot(Environment & env)
 
 // this is a simple recursive version. the iterative version is more
 // difficult with the ast data structure used (no parent pointer).
-// this limits the practical depth of our AST
-Expression Expression::eval(Environment & env) {
-	Expression check = env.get_exp(m_head);
-	Environment lambdaEnv = env;
-	if (m_head.asSymbol() == "apply") {
+// this limits the practical depth of our AST; the bytecode mode runs lambda
+// calls on an explicit stack with proper tail calls instead
+Expression Expression::eval(Environment & env) const {
+
+	if (m_form == ApplyForm) {
 		return doApply(env);
 	}
-	else if (m_tail.empty() && m_head.asSymbol() != "list" && m_head.asSymbol() != "apply") {
+	else if (m_tail.empty() && m_form != ListForm) {
 		return handle_lookup(m_head, env);
 	}
-	// handle begin special-form
-	else if (m_head.isSymbol() && m_head.asSymbol() == "begin") {
+
+	switch (m_form) {
+	case BeginForm:
 		return handle_begin(env);
-	}
-	// handle define special-form
-	else if (m_head.isSymbol() && m_head.asSymbol() == "define") {
+	case DefineForm:
 		return handle_define(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "lambda") {
+	case LambdaForm:
 		return handle_lambda(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "map")
-	{
-		return doMap(env, lambdaEnv);
-
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "set-property")
-	{
+	case MapForm:
+		return doMap(env);
+	case SetPropertyForm:
 		return doSetProperty(env);
-		//throw SemanticError("here");
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "get-property")
-	{
-
+	case GetPropertyForm:
 		return doGetProperty(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "discrete-plot")
-	{
+	case DiscretePlotForm:
 		return do_discrete_plot(env);
-	}
-	else if (m_head.isSymbol() && m_head.asSymbol() == "continuous-plot")
-	{
+	case ContinuousPlotForm:
 		return do_continuous_plot(env);
+	case MemoizeForm:
+		return handle_memoize(env);
+	case MemoStatsForm:
+		return handle_memo_stats(env);
+	default:
+		break;
 	}
 
-	// else attempt to treat as procedure
-	else {
-		if (env.is_known(m_head) && check.m_head.asSymbol() == "lambda")
-		{
-			return doLambda(lambdaEnv, env, check);
+	// else attempt to treat as procedure. Unless a local frame shadows the
+	// head it names a global, which the call site resolves once per version
+	// of the global frame. Lambda bodies never define globals, so a cached
+	// lambda stays in place for the call unless an argument defines one.
+	if (!env.is_local(m_head)) {
+		if (!m_cache || m_cache->version.load(std::memory_order_acquire) != env.version())
+			cache_call(env);
+		const Expression * lambda = m_cache->lambda.load(std::memory_order_relaxed);
+		Procedure proc = m_cache->proc.load(std::memory_order_relaxed);
+		if (lambda != nullptr && !m_cache->defines.load(std::memory_order_relaxed))
+			return doLambda(env, *lambda);
+		if (proc != nullptr) {
+			std::vector<Expression> results;
+			for (Expression::ConstIteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
+				results.push_back(it->eval(env));
+			}
+			return proc(results);
 		}
+	}
 
+	if (env.is_exp(m_head))
+	{
+		Expression check = env.get_exp(m_head);
+		if (check.m_form == LambdaForm)
+			return doLambda(env, check);
+	}
 
-		std::vector<Expression> results;
-		for (Expression::IteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
-			results.push_back(it->eval(env));
-		}
-		return apply(m_head, results, env);
+	std::vector<Expression> results;
+	for (Expression::ConstIteratorType it = m_tail.begin(); it != m_tail.end(); ++it) {
+		results.push_back(it->eval(env));
 	}
+	return apply(m_head, results, env);
 }
 
 
 bool definesProc(const Expression & exp)
 {
-	if (exp.head().asSymbol() == "conj" || exp.head().asSymbol() == "arg" || exp.head().asSymbol() == "mag" ||
-		exp.head().asSymbol() == "imag" || exp.head().asSymbol() == "real" || exp.head().asSymbol() == "tan" ||
-		exp.head().asSymbol() == "cos" || exp.head().asSymbol() == "sin" || exp.head().asSymbol() == "ln" ||
-		exp.head().asSymbol() == "^" || exp.head().asSymbol() == "sqrt" || exp.head().asSymbol() == "/" ||
-		exp.head().asSymbol() == "*" || exp.head().asSymbol() == "-" || exp.head().asSymbol() == "+" ||
-		exp.head().asSymbol() == "conj")
-		return true;
-	else
-		return false;
+	// interned once, so each check is a pointer comparison
+	static const Atom procs[] = { Atom("conj"), Atom("arg"), Atom("mag"), Atom("imag"),
+		Atom("real"), Atom("tan"), Atom("cos"), Atom("sin"), Atom("ln"), Atom("^"),
+		Atom("sqrt"), Atom("/"), Atom("*"), Atom("-"), Atom("+") };
+
+	for (auto & p : procs) {
+		if (exp.head() == p)
+			return true;
+	}
+	return false;
 }
 
 std::ostream & operator<<(std::ostream & out, const Expression & exp) {
 
+	static const Atom LIST("list");
+	static const Atom REST("rest");
+	static const Atom LENGTH("length");
+	static const Atom LAMBDA("lambda");
 
 	if (exp.head().isNone())
 	{
@@ -1120,22 +1676,30 @@ std::ostream & operator<<(std::ostream & out, const Expression & exp) {
 	}
 	else
 	{
-		if (!exp.head().isComplex() && exp.head().asSymbol() != "length") {
+		if (!exp.head().isComplex() && exp.head() != LENGTH) {
 			out << "(";
 		}
-		if (exp.head().asSymbol() != "list" && exp.head().asSymbol() != "rest" &&
-			exp.head().asSymbol() != "length" && exp.head().asSymbol() != "lambda") {
+		if (exp.head() != LIST && exp.head() != REST &&
+			exp.head() != LENGTH && exp.head() != LAMBDA) {
 			out << exp.head();
 
 			if (definesProc(exp))
 				out << " ";
 		}
-		for (auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e) {
+		const std::vector<double> * packed = exp.packedNumbers();
+		if (packed != nullptr) {
+			for (std::size_t i = 0; i < packed->size(); ++i) {
+				out << "(" << Atom((*packed)[i]) << ")";
+				if (i + 1 != packed->size())
+					out << " ";
+			}
+		}
+		for (auto e = exp.tailConstBegin(); packed == nullptr && e != exp.tailConstEnd(); ++e) {
 			out << *e;
 			if (e != exp.tailConstEnd() - 1)
 				out << " ";
 		}
-		if (!exp.head().isComplex() && exp.head().asSymbol() != "length") {
+		if (!exp.head().isComplex() && exp.head() != LENGTH) {
 			out << ")";
 		}
 	}
@@ -1148,6 +1712,14 @@ bool Expression::operator==(const Expression & exp) const noexcept {
 
 	result = result && (m_tail.size() == exp.m_tail.size());
 
+	const std::vector<double> * left = m_tail.numbers();
+	const std::vector<double> * right = exp.m_tail.numbers();
+	if (result && left != nullptr && right != nullptr) {
+		for (std::size_t i = 0; result && i < left->size(); i++)
+			result = (Atom((*left)[i]) == Atom((*right)[i]));
+		return result;
+	}
+
 	if (result) {
 		for (auto lefte = m_tail.begin(), righte = exp.m_tail.begin();
 			(lefte != m_tail.end()) && (righte != exp.m_tail.end());
@@ -1159,11 +1731,30 @@ bool Expression::operator==(const Expression & exp) const noexcept {
 	return result;
 }
 
+bool Expression::identical(const Expression & exp) const noexcept {
+
+	if (!(m_head == exp.m_head) || (m_tail.size() != exp.m_tail.size()) ||
+		(propertyList.size() != exp.propertyList.size()))
+		return false;
+
+	for (auto left = propertyList.begin(), right = exp.propertyList.begin();
+		left != propertyList.end(); ++left, ++right) {
+		if ((left->first != right->first) || !left->second.identical(right->second))
+			return false;
+	}
+
+	for (std::size_t i = 0; i < m_tail.size(); i++) {
+		if (!m_tail[i].identical(exp.m_tail[i]))
+			return false;
+	}
+	return true;
+}
+
 Expression Expression::getProperty(std::string str)
 {
 	Expression hasProperty;
 	auto found = propertyList.find(str);
-	if (found != propertyList.cend())
+	if (found != propertyList.end())
 	{
 		hasProperty = found->second;
 	}
@@ -4,6 +4,10 @@ Defines the Expression type and assiciated functions.
 #ifndef EXPRESSION_HPP
 #define EXPRESSION_HPP
 
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
 #include <string>
 #include <vector>
 #include <map>
@@ -14,17 +18,52 @@ Defines the Expression type and assiciated functions.
 // forward declare Environment
 class Environment;
 
+// forward declare MemoTable
+class MemoTable;
+
 /*! \class Expression
 \brief An expression is a tree of Atoms.
 
 An expression is an atom called the head followed by a (possibly empty) 
 list of expressions called the tail.
+
+The tail is shared between copies of an expression until one of them changes
+it, so copying an expression takes constant time whatever its size, and
+changing a copy only copies the nodes on the path to the change.
  */
 class Expression {
 public:
 
   typedef std::vector<Expression>::const_iterator ConstIteratorType;
 
+  /*! \enum Form
+    \brief The special form named by the head, resolved once per node so
+    eval can dispatch with a single switch.
+   */
+  enum Form { NoForm,            ///< procedure call, literal or symbol lookup
+	      ListForm,          ///< head is list, never looked up as a symbol
+	      ApplyForm,
+	      BeginForm,
+	      DefineForm,
+	      LambdaForm,
+	      MapForm,
+	      SetPropertyForm,
+	      GetPropertyForm,
+	      DiscretePlotForm,
+	      ContinuousPlotForm,
+	      MemoizeForm,
+	      MemoStatsForm
+  };
+
+  /*! \enum Effect
+    \brief What calling a lambda can do besides computing its value, from
+    least to most severe. See effects.hpp.
+   */
+  enum Effect { Pure,          ///< depends only on the arguments
+		ReadsGlobals,  ///< depends on symbols bound outside the call
+		Mutating       ///< defines symbols
+  };
+
   /// Default construct and Expression, whose type in NoneType
   Expression();
 
@@ -33,25 +72,55 @@ public:
   */
   Expression(const Atom & a);
 
-  /// deep-copy construct an expression (recursive)
+  /*! Construct a list of numbers, stored packed as plain doubles. It
+    behaves as a list of number expressions.
+    \param head the head of the list
+    \param numbers the elements
+  */
+  Expression(const Atom & head, std::vector<double> numbers);
+
+  /// copy construct an expression, sharing its tail
   Expression(const Expression & a);
 
-  /// deep-copy assign an expression  (recursive)
+  /// copy assign an expression, sharing its tail
   Expression & operator=(const Expression & a);
 
-  /// return a reference to the head Atom
+  /// move construct an expression, leaving a of type None
+  Expression(Expression && a) noexcept;
+
+  /// move assign an expression, leaving a of type None
+  Expression & operator=(Expression && a) noexcept;
+
+  /// return a reference to the head Atom, assign through setHead to change it
   Atom & head();
 
   /// return a const-reference to the head Atom
   const Atom & head() const;
 
+  /// replace the head Atom, updating the special form it names
+  void setHead(const Atom & a);
+
+  /// the special form named by the head
+  Form form() const noexcept;
+
+  /// the effect of calling a lambda built by the lambda special form,
+  /// Mutating for any other expression
+  Effect effect() const noexcept;
+
   /// append Atom to tail of the expression
   void append(const Atom & a);
 
   /// append Expression to the tail of the expression
   void appendExpression(const Expression & a);
 
-  /// return a pointer to the last expression in the tail, or nullptr
+  /// append Expression to the tail of the expression, moving from it
+  void appendExpression(Expression && a);
+
+  /// reserve room in the tail for n expressions
+  void reserve(std::size_t n);
+
+  /// return a pointer to the last expression in the tail, or nullptr.
+  /// The tail is unshared first, so changes through it affect no copy.
   Expression * tail();
 
  // bool isEqual(Expression & exp, std::vector<Expression> args);
@@ -62,6 +131,13 @@ public:
   /// return a const-iterator to the tail end
   ConstIteratorType tailConstEnd() const noexcept;
 
+  /// the elements of a packed list of numbers, or nullptr when the tail is
+  /// empty or not packed
+  const std::vector<double> * packedNumbers() const noexcept;
+
+  /// true for a number with no tail or properties, which a packed list can hold
+  bool isBareNumber() const noexcept;
+
   /// convienience member to determine if head atom is a number
   bool isHeadNumber() const noexcept;
 
@@ -72,10 +148,33 @@ public:
   bool isHeadComplex() const noexcept;
 
   /// Evaluate expression using a post-order traversal (recursive)
-  Expression eval(Environment & env);
+  Expression eval(Environment & env) const;
 
   /// equality comparison for two expressions (recursive)
   bool operator==(const Expression & exp) const noexcept;
+
+  /// equality comparison that also compares property lists (recursive)
+  bool identical(const Expression & exp) const noexcept;
+
+  /*! Call a lambda with evaluated arguments, answering from its memo
+    table when it has one
+    \param env the environment of the caller
+    \param args the argument values
+    \return the value of the body with the parameters bound to args
+    \throws SemanticError when a semantic error is encountered
+   */
+  Expression call(Environment & env, const std::vector<Expression> & args) const;
+
+  /// the memo table of a memoized lambda, or nullptr
+  const MemoTable * memo() const noexcept;
+
+  /// for a symbol inside the body of a lambda built by the lambda special
+  /// form, the frame slot of the parameter it names, otherwise -1
+  int slot() const noexcept;
+
+  /// for a symbol with a slot, the number of lambdas between the one whose
+  /// body holds it and the one whose parameter it names
+  int depth() const noexcept;
   
   Expression getProperty(std::string str);
   
@@ -85,43 +184,150 @@ private:
   // the head of the expression
   Atom m_head;
 
-  // the tail list is expressed as a vector for access efficiency
-  // and cache coherence, at the cost of wasted memory.
-  std::vector<Expression> m_tail;
+  // the special form m_head names, kept in step with m_head
+  Form m_form;
+
+  // for a lambda, the effect of calling it
+  Effect m_effect;
+
+  // for a symbol inside a lambda body, the frame slot of the parameter it
+  // names, or -1 when it must be looked up by name. For a lambda, 0 once the
+  // symbols of its body have been resolved.
+  int m_slot;
+
+  // for a symbol with a slot, how many frames out from the innermost the
+  // parameter is bound
+  int m_depth;
+
+  // what the head of a call resolved to in the global frame, valid while
+  // the global frame is at version. Copies of a node share the cache. The
+  // fields are atomic since the workers of a parallel map share it; version
+  // is stored last, with release ordering.
+  struct CallCache {
+    std::atomic<std::uint64_t> version;
+    std::atomic<Expression (*)(const std::vector<Expression> & args)> proc;
+    std::atomic<const Expression *> lambda;
+    std::atomic<bool> defines; // an argument contains a define, which may rebind lambda
+
+    CallCache(): version(0), proc(nullptr), lambda(nullptr), defines(false) {}
+  };
+  mutable std::shared_ptr<CallCache> m_cache;
+
+  // results of a memoized lambda, shared by its copies
+  std::shared_ptr<MemoTable> m_memo;
 
   // convenience typedef
   typedef std::vector<Expression>::iterator IteratorType;
+
+  // the extent of the data of a plot and its scale to the plot area, passed
+  // between the plot helpers
+  struct PlotBounds {
+    double x_min, x_max, y_min, y_max;
+    double x_scale, y_scale;
+  };
+
+  // the tail list is expressed as a vector for access efficiency and cache
+  // coherence. The vector lives in a reference counted block shared by the
+  // copies of an expression; non-const access copies it first when it is
+  // shared, so a change is never seen through another copy. A list of
+  // numbers may be packed, see packedNumbers, in which case the vector is
+  // filled on first access and non-const access unpacks the block.
+  class Tail {
+  public:
+    Tail() noexcept;
+    explicit Tail(std::vector<double> && numbers);
+    Tail(const Tail & other) noexcept;
+    Tail & operator=(const Tail & other) noexcept;
+    Tail(Tail && other) noexcept;
+    Tail & operator=(Tail && other) noexcept;
+    ~Tail();
+
+    std::size_t size() const noexcept;
+    bool empty() const noexcept;
+
+    const Expression & operator[](std::size_t i) const;
+    ConstIteratorType begin() const noexcept;
+    ConstIteratorType end() const noexcept;
+    const std::vector<double> * numbers() const noexcept;
+
+    Expression & operator[](std::size_t i);
+    IteratorType begin();
+    IteratorType end();
+    Expression & back();
+    void push_back(const Expression & e);
+    void push_back(Expression && e);
+    void emplace_back(const Atom & a);
+    void reserve(std::size_t n);
+    void clear() noexcept;
+
+  private:
+    struct Block;
+    Block * block; // nullptr when empty
+
+    // the vector of an unshared block
+    std::vector<Expression> & items();
+  };
+  Tail m_tail;
   
   // internal helper methods
-  Expression handle_lookup(const Atom & head, const Environment & env);
-  Expression handle_define(Environment & env);
-  Expression doApply(Environment & env);
-  Expression doMap(Environment & env, Environment & lambdaEnv);
-  Expression doLambda(Environment &lambdaEnv, Environment &env, Expression check);
-  Expression doSetProperty(Environment & env);
-  Expression doGetProperty(Environment & env);
-  Expression handle_begin(Environment & env);
-  Expression handle_lambda(Environment & env);
-  Expression do_discrete_plot(Environment & env);
-  Expression do_continuous_plot(Environment & env);
-  Expression create_data_pairs(Expression tail_1, Environment & env);
-  Expression make_plot_bound(Environment &env, Expression origin_head, Expression &output);
+  Expression handle_lookup(const Atom & head, const Environment & env) const;
+  Expression handle_define(Environment & env) const;
+  Expression doApply(Environment & env) const;
+  Expression doMap(Environment & env) const;
+  Expression doLambda(Environment & env, const Expression & lambda) const;
+  Expression doSetProperty(Environment & env) const;
+  Expression doGetProperty(Environment & env) const;
+  Expression handle_begin(Environment & env) const;
+  Expression handle_lambda(Environment & env) const;
+  Expression handle_memoize(Environment & env) const;
+  Expression handle_memo_stats(Environment & env) const;
+  void resolve(std::vector<std::vector<Atom> > & scopes);
+  void cache_call(const Environment & env) const;
+  Expression do_discrete_plot(Environment & env) const;
+  Expression do_continuous_plot(Environment & env) const;
+  Expression create_data_pairs(Expression tail_1, Environment & env) const;
+  Expression make_plot_bound(Expression origin_head, Expression &output, const PlotBounds & bounds) const;
  // Expression make_plot_labels(Environment &env, Expression origin_head);
-  void get_min_max(Expression tail_0, Expression tail_1);
-  Expression get_labels(Expression tail_1, Expression & output, int plot);
-  bool map_contains(std::string key);
-  Expression make_plot_coords(Environment &env, Expression origin_head, bool y_overlap, bool x_overlap, Expression &output);
-  Expression plot_data(Environment &env, Expression tail_0, Expression &output, bool x_overlap, int plot);
+  void get_min_max(Expression tail_0, Expression tail_1, PlotBounds & bounds) const;
+  Expression get_labels(Expression tail_1, Expression & output, int plot, const PlotBounds & bounds) const;
+  Expression make_plot_coords(Expression origin_head, bool y_overlap, bool x_overlap, Expression &output, const PlotBounds & bounds) const;
+  Expression plot_data(Expression tail_0, Expression &output, bool x_overlap, int plot, const PlotBounds & bounds) const;
+
+  // the properties of an expression. Most expressions have none, so the
+  // map is allocated by the first property set and shared by copies until
+  // one of them sets another.
+  class Properties {
+  public:
+    typedef std::map<std::string, Expression> Map;
+
+    std::size_t size() const noexcept;
+    Map::const_iterator begin() const noexcept;
+    Map::const_iterator end() const noexcept;
+    Map::const_iterator find(const std::string & key) const;
 
-  //std::map<std::string, std::string> propertyMap;
-  std::map<std::string, Expression> propertyList;
-  std::map<std::string, double> min_max_list;
-  std::map<std::string, Expression> parameter_list;
+    Expression & operator[](const std::string & key);
 
+  private:
+    std::shared_ptr<Map> block; // nullptr when empty
 
+    static const Map & none();
+  };
+  Properties propertyList;
 
 };
 
+inline const Atom & Expression::head() const {
+  return m_head;
+}
+
+inline bool Expression::isHeadNumber() const noexcept {
+  return m_head.isNumber();
+}
+
+inline bool Expression::isHeadComplex() const noexcept {
+  return m_head.isComplex();
+}
+
 /// Render expression to output stream
 std::ostream & operator<<(std::ostream & out, const Expression & exp);
 
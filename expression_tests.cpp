@@ -25,4 +25,102 @@ TEST_CASE( "Test symbol expression", "[expression]" ) {
 
   REQUIRE(!exp.isHeadNumber());
   REQUIRE(exp.isHeadSymbol());
-}
\ No newline at end of file
+}
+TEST_CASE( "Test special form tagging", "[expression]" ) {
+
+  REQUIRE(Expression().form() == Expression::NoForm);
+  REQUIRE(Expression(1.0).form() == Expression::NoForm);
+  REQUIRE(Expression(Atom("+")).form() == Expression::NoForm);
+  REQUIRE(Expression(Atom("list")).form() == Expression::ListForm);
+  REQUIRE(Expression(Atom("begin")).form() == Expression::BeginForm);
+  REQUIRE(Expression(Atom("continuous-plot")).form() == Expression::ContinuousPlotForm);
+
+  Expression exp(Atom("define"));
+  Expression copy(exp);
+  REQUIRE(copy.form() == Expression::DefineForm);
+
+  exp.setHead(Atom("lambda"));
+  REQUIRE(exp.form() == Expression::LambdaForm);
+  exp.setHead(Atom(2.0));
+  REQUIRE(exp.form() == Expression::NoForm);
+}
+
+TEST_CASE( "Test copies share the tail until changed", "[expression]" ) {
+
+  Expression big(Atom("list"));
+  for(int i = 0; i < 1000000; ++i){
+    big.append(Atom(static_cast<double>(i)));
+  }
+
+  {
+    INFO("a copy refers to the same elements");
+    Expression copy(big);
+    REQUIRE(&*copy.tailConstBegin() == &*big.tailConstBegin());
+
+    Expression assigned;
+    assigned = big;
+    REQUIRE(&*assigned.tailConstBegin() == &*big.tailConstBegin());
+  }
+
+  {
+    INFO("appending to a copy leaves the original unchanged");
+    Expression copy(big);
+    copy.append(Atom(-1.0));
+    REQUIRE(copy.tailConstEnd() - copy.tailConstBegin() == 1000001);
+    REQUIRE(big.tailConstEnd() - big.tailConstBegin() == 1000000);
+    REQUIRE(&*copy.tailConstBegin() != &*big.tailConstBegin());
+  }
+
+  {
+    INFO("changing a nested copy copies only the path to the change");
+    Expression inner(Atom("list"));
+    inner.append(Atom(1.0));
+    Expression outer(Atom("list"));
+    outer.appendExpression(inner);
+    outer.appendExpression(big);
+
+    Expression copy(outer);
+    copy.tail()->append(Atom(2.0));
+
+    REQUIRE(outer.tailConstBegin()->tailConstEnd() - outer.tailConstBegin()->tailConstBegin() == 1);
+    REQUIRE(copy.tailConstBegin()->tailConstEnd() - copy.tailConstBegin()->tailConstBegin() == 1);
+    REQUIRE((copy.tailConstBegin() + 1)->tailConstEnd() - (copy.tailConstBegin() + 1)->tailConstBegin() == 1000001);
+    REQUIRE(&*(outer.tailConstBegin() + 1)->tailConstBegin() == &*big.tailConstBegin());
+    REQUIRE(outer != copy);
+  }
+}
+
+TEST_CASE( "Test moving an expression", "[expression]" ) {
+
+  Expression list(Atom("list"));
+  list.append(Atom(1.0));
+  list.append(Atom(2.0));
+  Expression expected(list);
+  const Expression * first = &*list.tailConstBegin();
+
+  Expression moved(std::move(list));
+  REQUIRE(moved == expected);
+  REQUIRE(&*moved.tailConstBegin() == first);
+  REQUIRE(list.head().isNone());
+  REQUIRE(list.tailConstBegin() == list.tailConstEnd());
+
+  Expression assigned;
+  assigned = std::move(moved);
+  REQUIRE(assigned == expected);
+  REQUIRE(moved.head().isNone());
+
+  Expression outer(Atom("list"));
+  outer.appendExpression(std::move(assigned));
+  REQUIRE(*outer.tailConstBegin() == expected);
+  REQUIRE(&*outer.tailConstBegin()->tailConstBegin() == first);
+}
+
+TEST_CASE( "Test expression node size", "[expression]" ) {
+
+  // properties live in a block allocated on first use and the plot helpers
+  // keep no state in the node, raise this only with good reason
+  REQUIRE(sizeof(Expression) <= 96);
+
+  Expression point(Atom("list"));
+  REQUIRE(point.getProperty("\"object-name\"") == Expression());
+}
@@ -11,17 +11,90 @@
 #include "environment.hpp"
 #include "semantic_error.hpp"
 
+Interpreter::Interpreter(): folded(false), evalMode(TreeWalk), compiled(false){}
+
+void Interpreter::setMode(EvalMode mode) noexcept{
+
+  evalMode = mode;
+}
+
+Interpreter::EvalMode Interpreter::mode() const noexcept{
+
+  return evalMode;
+}
+
+void Interpreter::setAutoMemoize(bool enable) noexcept{
+
+  env.set_auto_memoize(enable);
+}
+
+void Interpreter::setMapThreads(std::size_t threads) noexcept{
+
+  env.set_map_threads(threads);
+}
+
 bool Interpreter::parseStream(std::istream & expression) noexcept{
 
-  TokenSequenceType tokens = tokenize(expression);
+  SourceBuffer source;
+  source.read(expression);
+
+  return parseSource(source);
+};
+
+bool Interpreter::parseSource(const SourceBuffer & source) noexcept{
+
+  return parseSource(source.data(), source.size());
+}
+
+bool Interpreter::parseSource(const SourceBuffer & source, const AstCache & cache) noexcept{
+
+  arena.release();
+  compiled = false;
+  folded = false;
+
+  {
+    NodeArena::Scope scope(arena);
+    if(cache.load(source, ast)){
+      return true;
+    }
+  }
 
-  ast = parse(tokens);
+  if(!parseSource(source)){
+    return false;
+  }
+  cache.store(source, ast);
+  return true;
+}
+
+bool Interpreter::parseSource(const char * data, std::size_t size) noexcept{
+
+  // the previous AST is no longer needed, any of its nodes still in use
+  // keep their chunk of the arena alive
+  arena.release();
+  ast = parse(data, size, arena);
+  compiled = false;
+  folded = false;
 
   return (ast != Expression());
-};
+}
 				     
 
 Expression Interpreter::evaluate(){
 
+  // folding depends only on the defines of this and earlier programs, so
+  // the AST is folded once however often it is evaluated
+  if(!folded){
+    ast = folder.fold(ast, env);
+    folded = true;
+  }
+
+  if(evalMode == Bytecode){
+    if(!compiled){
+      program = compile(ast, env);
+      compiled = true;
+    }
+    return vm.run(program, env);
+  }
+
   return ast.eval(env);
 }
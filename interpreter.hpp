@@ -8,12 +8,18 @@ It maintains an environment during evaluation.
 #define INTERPRETER_HPP
 
 // system includes
+#include <cstddef>
 #include <istream>
 #include <string>
 
 // module includes
+#include "arena.hpp"
+#include "ast_cache.hpp"
+#include "bytecode.hpp"
 #include "environment.hpp"
 #include "expression.hpp"
+#include "optimizer.hpp"
+#include "source.hpp"
 
 /*! \class Interpreter
 \brief Class to parse and evaluate an expression (program)
@@ -21,17 +27,67 @@ It maintains an environment during evaluation.
 Interpreter has an Environment, which starts at a default.
 The parse method builds an internal AST.
 The eval method updates Environment and returns last result.
+
+Before evaluation the AST is passed through a ConstantFolder.
+Evaluation uses one of two engines, selected with setMode: the recursive
+tree walker in Expression::eval, or the bytecode compiler and stack virtual
+machine in the bytecode module.
 */
 class Interpreter {
 public:
 
+  /*! \enum EvalMode
+    \brief the engine used by evaluate
+   */
+  enum EvalMode { TreeWalk, ///< walk the AST directly
+		  Bytecode  ///< compile the AST and run it on the virtual machine
+  };
+
+  /// Construct an interpreter in the default environment and TreeWalk mode
+  Interpreter();
+
+  /// select the engine used by evaluate
+  void setMode(EvalMode mode) noexcept;
+
+  /// return the engine used by evaluate
+  EvalMode mode() const noexcept;
+
+  /// select whether lambdas found to be pure are memoized when built
+  void setAutoMemoize(bool enable) noexcept;
+
+  /// select the number of threads map may use for a large list
+  void setMapThreads(std::size_t threads) noexcept;
+
   /*! Parse into an internal Expression from a stream
     \param expression the raw text stream repreenting the candidate expression
     \return true on successful parsing 
    */
   bool parseStream(std::istream &expression) noexcept;
 
-  /*! Evaluate the Expression by walking the tree, returning the result.
+  /*! Parse into an internal Expression from a buffer, e.g. a mapped file
+    \param source the text of the candidate expression
+    \return true on successful parsing
+   */
+  bool parseSource(const SourceBuffer &source) noexcept;
+
+  /*! Parse into an internal Expression from characters, e.g. a form read
+    by a FormReader. The environment is kept, so the forms of a program
+    may be parsed and evaluated one at a time.
+    \param data the first character of the candidate expression
+    \param size the number of characters
+    \return true on successful parsing
+   */
+  bool parseSource(const char *data, std::size_t size) noexcept;
+
+  /*! Parse into an internal Expression from a buffer, loading the AST from
+    a cache if it holds it, else parsing and storing it there
+    \param source the text of the candidate expression
+    \param cache the cache to use, which may be disabled
+    \return true on successful parsing
+   */
+  bool parseSource(const SourceBuffer &source, const AstCache &cache) noexcept;
+
+  /*! Evaluate the Expression using the selected engine, returning the result.
     \return the Expression resulting from the evaluation in the current environment
     \throws SemanticError when a semantic error is encountered
    */
@@ -44,6 +100,25 @@ private:
 
   // the AST
   Expression ast;
+
+  // the parser allocates the nodes of the AST from here
+  NodeArena arena;
+
+  // folds constant subtrees before evaluation
+  ConstantFolder folder;
+
+  // true once the AST has been folded
+  bool folded;
+
+  // the selected engine
+  EvalMode evalMode;
+
+  // the AST compiled for the virtual machine, when up to date
+  Chunk program;
+  bool compiled;
+
+  // the virtual machine
+  VirtualMachine vm;
 };
 
 #endif
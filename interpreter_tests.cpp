@@ -303,6 +303,161 @@ TEST_CASE( "Test Interpreter special forms: begin, define, and lambda", "[interp
 
  }
 
+TEST_CASE( "Test lambda call scope", "[interpreter]" ) {
+
+  {
+    INFO("parameters do not leak into the global environment");
+    std::string program = "(begin (define f (lambda (x) (* x x))) (f 2) x)";
+    Interpreter interp;
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss) == true);
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+
+  {
+    INFO("arguments are evaluated in the caller scope");
+    std::string program = "(begin (define x 5) (define f (lambda (x y) (+ x y))) (f 1 x))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(6.));
+  }
+
+  {
+    INFO("calls see globals defined after the lambda");
+    std::string program = "(begin (define f (lambda (y) (+ x y))) (define x 3) (f 4))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(7.));
+  }
+
+  {
+    INFO("parameters are found by slot in the frame of the callee");
+    std::string program = "(begin (define g (lambda (b) b)) (define f (lambda (a b) (g a))) (f 1 2))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(1.));
+  }
+
+  {
+    INFO("parameter references in the body are given their slots");
+    Expression lambda = run("(lambda (x y) (+ y (* x z)))");
+    Expression::ConstIteratorType sum = (lambda.tailConstBegin() + 1)->tailConstBegin();
+    REQUIRE(sum->slot() == 1);
+    Expression::ConstIteratorType product = (sum + 1)->tailConstBegin();
+    REQUIRE(product->slot() == 0);
+    REQUIRE((product + 1)->slot() == -1);
+  }
+
+  {
+    INFO("parameters of an enclosing lambda are addressed by depth");
+    Expression lambda = run("(lambda (x) (lambda (y) (+ x y)))");
+    Expression::ConstIteratorType sum = ((lambda.tailConstBegin() + 1)->tailConstBegin() + 1)->tailConstBegin();
+    REQUIRE(sum->slot() == 0);
+    REQUIRE(sum->depth() == 1);
+    REQUIRE((sum + 1)->slot() == 0);
+    REQUIRE((sum + 1)->depth() == 0);
+  }
+
+  {
+    INFO("a nested lambda called from the enclosing body reads its parameters");
+    std::string program = "(begin (define f (lambda (x) (begin (define g (lambda (y) (+ x y))) (g 1)))) (f 5))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(6.));
+  }
+
+  {
+    INFO("called from elsewhere, a nested lambda sees the parameters of its caller");
+    std::string program = "(begin (define mk (lambda (x) (lambda (y) (+ x y)))) (define add (mk 5)) "
+      "(define k (lambda (a x) (add a))) (k 1 20))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(21.));
+  }
+
+  {
+    INFO("free symbols still see the parameters of the caller");
+    std::string program = "(begin (define g (lambda (y) (+ x y))) (define f (lambda (x) (g 1))) (f 5))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(6.));
+  }
+
+  {
+    INFO("a define in the body rebinds the parameter slot");
+    std::string program = "(begin (define f (lambda (x) (begin (define x (* x 10)) (+ x 1)))) (f 2))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(21.));
+  }
+
+  {
+    INFO("a parameter may not name a procedure or a special form");
+    for(std::string program : {"(lambda (sin) 1)", "(lambda (x list) 1)", "(lambda (begin) 1)",
+	  "(begin (define f (lambda (define) 1)) (f 2))"}){
+      Interpreter interp;
+      std::istringstream iss(program);
+      REQUIRE(interp.parseStream(iss) == true);
+      REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+    }
+  }
+
+  {
+    INFO("wrong number of arguments");
+    std::string program = "(begin (define f (lambda (x) x)) (f 1 2))";
+    Interpreter interp;
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss) == true);
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+}
+
+TEST_CASE( "Test call site caching", "[interpreter]" ) {
+
+  {
+    INFO("redefining a lambda invalidates the calls made through it");
+    std::string program = "(begin (define f (lambda (x) (* x 2))) (define g (lambda (x) (f x))) "
+      "(define a (g 1)) (define f (lambda (x) (* x 3))) (list a (g 1)))";
+    Expression result = run(program);
+    Expression expected(Atom("list"));
+    expected.append(Atom(2.));
+    expected.append(Atom(3.));
+    REQUIRE(result == expected);
+  }
+
+  {
+    INFO("a parameter shadows the global a call site resolved to");
+    std::string program = "(begin (define f (lambda (x) 1)) (define h (lambda (x) (* x 10))) "
+      "(define g (lambda (f) (f 2))) (list (f 0) (g h) (f 0)))";
+    Expression result = run(program);
+    Expression expected(Atom("list"));
+    expected.append(Atom(1.));
+    expected.append(Atom(20.));
+    expected.append(Atom(1.));
+    REQUIRE(result == expected);
+  }
+
+  {
+    INFO("the lambda is resolved before an argument redefines it");
+    std::string program = "(begin (define f (lambda (x) (+ x 1))) (f (define f 5)))";
+    Expression result = run(program);
+    REQUIRE(result == Expression(6.));
+  }
+
+  {
+    INFO("the cache follows definitions made between evaluations");
+    Interpreter interp;
+    std::istringstream first("(define f (lambda (x) (* x 2)))");
+    REQUIRE(interp.parseStream(first) == true);
+    interp.evaluate();
+
+    std::istringstream call("(f 4)");
+    REQUIRE(interp.parseStream(call) == true);
+    REQUIRE(interp.evaluate() == Expression(8.));
+
+    std::istringstream second("(define f (lambda (x) (* x 3)))");
+    REQUIRE(interp.parseStream(second) == true);
+    interp.evaluate();
+
+    std::istringstream again("(f 4)");
+    REQUIRE(interp.parseStream(again) == true);
+    REQUIRE(interp.evaluate() == Expression(12.));
+  }
+}
+
 TEST_CASE("list", "[interpreter]") {
 	{
 		std::string input = "(list 1 2 3 4)";
@@ -839,3 +994,111 @@ TEST_CASE("test empty list", "[interpreter]")
 
 
 
+
+TEST_CASE( "Test packed number lists", "[interpreter]" ) {
+
+  Expression unpacked(Atom("list"));
+  for(int i = 0; i < 4; ++i){
+    unpacked.append(Atom(static_cast<double>(i)));
+  }
+
+  {
+    INFO("lists of numbers are packed");
+    REQUIRE(run("(range 0 3 1)").packedNumbers() != nullptr);
+    REQUIRE(run("(list 0 1 2 3)").packedNumbers() != nullptr);
+    REQUIRE(run("(map - (list 0 -1 -2 -3))").packedNumbers() != nullptr);
+    REQUIRE(run("(begin (define f (lambda (x) (+ x 1))) (map f (range -1 2 1)))").packedNumbers() != nullptr);
+    REQUIRE(run("(list 0 1 (list 2))").packedNumbers() == nullptr);
+    REQUIRE(run("(list 0 I)").packedNumbers() == nullptr);
+    REQUIRE(run("(list 0 (set-property \"a\" 1 2))").packedNumbers() == nullptr);
+    REQUIRE(run("(list)").packedNumbers() == nullptr);
+  }
+
+  {
+    INFO("a packed list behaves as a list of numbers");
+    Expression packed = run("(range 0 3 1)");
+    REQUIRE(*packed.packedNumbers() == std::vector<double>({0, 1, 2, 3}));
+    REQUIRE(packed == unpacked);
+    REQUIRE(unpacked == packed);
+    REQUIRE(packed.tailConstEnd() - packed.tailConstBegin() == 4);
+    REQUIRE(*(packed.tailConstBegin() + 2) == Expression(2.));
+
+    std::ostringstream printed, expected;
+    printed << packed;
+    expected << unpacked;
+    REQUIRE(printed.str() == expected.str());
+
+    Expression copy(packed);
+    copy.append(Atom(4.));
+    REQUIRE(copy.packedNumbers() == nullptr);
+    REQUIRE(copy != packed);
+    REQUIRE(packed == unpacked);
+  }
+
+  {
+    INFO("the list procedures keep lists packed");
+    REQUIRE(run("(first (range 5 9 1))") == Expression(5.));
+    REQUIRE(run("(rest (range 0 3 1))") == run("(rest (list 0 (+ 0 1) 2 3))"));
+    Expression thousand(Atom("length"));
+    thousand.append(Atom(1000.));
+    REQUIRE(run("(length (range 0 999 1))") == thousand);
+    REQUIRE(run("(length (range 0 999 1))") == run("(length (map + (range 0 999 1)))"));
+    REQUIRE(run("(append (range 0 2 1) 3)").packedNumbers() != nullptr);
+    REQUIRE(run("(append (range 0 2 1) 3)") == unpacked);
+    REQUIRE(run("(append (range 0 1 1) (range 2 3 1))") == unpacked);
+    REQUIRE(run("(join (list 0 1) (range 2 3 1))") == unpacked);
+    REQUIRE(run("(join (list 0 1) (range 2 3 1))").packedNumbers() != nullptr);
+    REQUIRE(run("(append (range 0 1 1) (list 2 \"a\"))") == run("(list 0 1 2 \"a\")"));
+  }
+}
+
+TEST_CASE( "Test elementwise arithmetic on lists", "[interpreter]" ) {
+
+  {
+    INFO("numbers are broadcast over lists");
+    REQUIRE(run("(+ (list 1 2 3) 1)") == run("(list 2 3 4)"));
+    REQUIRE(run("(+ 1 (list 1 2 3) (list 10 20 30))") == run("(list 12 23 34)"));
+    REQUIRE(run("(* 2 (range 1 3 1))") == run("(list 2 4 6)"));
+    REQUIRE(run("(- (list 1 2 3))") == run("(list -1 -2 -3)"));
+    REQUIRE(run("(- 10 (list 1 2 3))") == run("(list 9 8 7)"));
+    REQUIRE(run("(/ (list 1 2 4))") == run("(list 1 0.5 0.25)"));
+    REQUIRE(run("(/ (list 2 4) (list 2 8))") == run("(list 1 0.5)"));
+    REQUIRE(run("(^ (list 2 3) 2)") == run("(list 4 9)"));
+    REQUIRE(run("(sqrt (list 4 9 16))") == run("(list 2 3 4)"));
+    REQUIRE(run("(ln (list 1))") == run("(list 0)"));
+    REQUIRE(run("(sin (list 0))") == run("(list 0)"));
+    REQUIRE(run("(cos (list 0))") == run("(list 1)"));
+    REQUIRE(run("(tan (list 0))") == run("(list 0)"));
+    REQUIRE(run("(+ (list) 1)") == run("(list)"));
+    REQUIRE(run("(* 2 (range 1 3 1))").packedNumbers() != nullptr);
+  }
+
+  {
+    INFO("lists the kernels cannot take are computed per element");
+    REQUIRE(run("(sqrt (list 4 -4))") == run("(list 2 (* 2 I))"));
+    REQUIRE(run("(+ (list 1 I) 1)") == run("(list 2 (+ I 1))"));
+    REQUIRE(run("(* (list (list 1 2) 3) 2)") == run("(list (list 2 4) 6)"));
+  }
+
+  {
+    INFO("the results match the scalar builtins");
+    std::string program = "(begin (define xs (range -2.0625 2 0.125)) "
+      "(list (+ xs 0.5 xs) (* xs 3 xs) (- xs 1) (- 1 xs) (/ xs 3) (/ xs) "
+      "(sqrt (* xs xs)) (^ 1.5 xs)))";
+    std::string scalar = "(begin (define xs (range -2.0625 2 0.125)) "
+      "(define f1 (lambda (x) (+ x 0.5 x))) (define f2 (lambda (x) (* x 3 x))) "
+      "(define f3 (lambda (x) (- x 1))) (define f4 (lambda (x) (- 1 x))) "
+      "(define f5 (lambda (x) (/ x 3))) (define f6 (lambda (x) (sqrt (* x x)))) "
+      "(define f7 (lambda (x) (^ 1.5 x))) "
+      "(list (map f1 xs) (map f2 xs) (map f3 xs) (map f4 xs) (map f5 xs) (map / xs) (map f6 xs) (map f7 xs)))";
+    REQUIRE(run(program) == run(scalar));
+  }
+
+  {
+    INFO("lists must have the same length");
+    std::istringstream iss("(+ (list 1 2) (list 1 2 3))");
+    Interpreter interp;
+    REQUIRE(interp.parseStream(iss) == true);
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+}
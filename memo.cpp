@@ -0,0 +1,125 @@
+#include "memo.hpp"
+
+// system includes
+#include <complex>
+#include <functional>
+
+// combine a value into a running hash
+static void combine(std::size_t & seed, std::size_t value){
+  seed ^= value + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+}
+
+// structural hash of an expression, consistent with Expression::identical
+static std::size_t hash_expression(const Expression & exp){
+
+  const Atom & head = exp.head();
+  std::size_t seed = 0;
+
+  if(head.isNumber()){
+    combine(seed, 1);
+    combine(seed, std::hash<double>()(head.asNumber()));
+  }
+  else if(head.isComplex()){
+    combine(seed, 2);
+    combine(seed, std::hash<double>()(head.asComplex().real()));
+    combine(seed, std::hash<double>()(head.asComplex().imag()));
+  }
+  else if(head.isSymbol()){
+    combine(seed, 3);
+    combine(seed, head.symbolId());
+  }
+
+  for(auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e){
+    combine(seed, hash_expression(*e));
+  }
+
+  return seed;
+}
+
+MemoTable::MemoTable(std::size_t capacity, const std::vector<Atom> & procs)
+  : capacity(capacity), procs(procs), hit_count(0), miss_count(0){}
+
+std::size_t MemoTable::hash(const std::vector<Expression> & args) const{
+
+  std::size_t seed = args.size();
+  for(auto & a : args){
+    combine(seed, hash_expression(a));
+  }
+  return seed;
+}
+
+// predicate, the argument lists are identical, properties included
+static bool same_args(const std::vector<Expression> & left, const std::vector<Expression> & right){
+
+  if(left.size() != right.size()) return false;
+
+  for(std::size_t i = 0; i < left.size(); ++i){
+    if(!left[i].identical(right[i])) return false;
+  }
+  return true;
+}
+
+bool MemoTable::find(const std::vector<Expression> & args, Expression & result){
+
+  std::size_t h = hash(args);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  auto range = index.equal_range(h);
+  for(auto it = range.first; it != range.second; ++it){
+    if(same_args(it->second->args, args)){
+      // move to the front, it is now the most recently used
+      entries.splice(entries.begin(), entries, it->second);
+      result = entries.front().result;
+      ++hit_count;
+      return true;
+    }
+  }
+
+  ++miss_count;
+  return false;
+}
+
+void MemoTable::insert(const std::vector<Expression> & args, const Expression & result){
+
+  if(capacity == 0) return;
+
+  std::size_t h = hash(args);
+
+  std::lock_guard<std::mutex> lock(mutex);
+
+  if(entries.size() == capacity){
+    // evict the least recently used entry
+    const Entry & last = entries.back();
+    auto range = index.equal_range(last.hash);
+    for(auto it = range.first; it != range.second; ++it){
+      if(&*it->second == &last){
+        index.erase(it);
+        break;
+      }
+    }
+    entries.pop_back();
+  }
+
+  entries.push_front(Entry{h, args, result});
+  index.emplace(h, entries.begin());
+}
+
+const std::vector<Atom> & MemoTable::procedures() const noexcept{
+  return procs;
+}
+
+std::size_t MemoTable::hits() const noexcept{
+  std::lock_guard<std::mutex> lock(mutex);
+  return hit_count;
+}
+
+std::size_t MemoTable::misses() const noexcept{
+  std::lock_guard<std::mutex> lock(mutex);
+  return miss_count;
+}
+
+std::size_t MemoTable::size() const noexcept{
+  std::lock_guard<std::mutex> lock(mutex);
+  return entries.size();
+}
@@ -0,0 +1,87 @@
+/*! \file memo.hpp
+Defines the result cache used to memoize calls to pure lambdas.
+
+Only lambdas analyzed as Pure (see effects.hpp) are memoized, since their
+value depends on nothing but their arguments. A MemoTable maps argument
+lists to results, evicting the least recently used entry once full. It is
+shared by every copy of the memoized lambda, and may be used from several
+threads at once.
+ */
+#ifndef MEMO_HPP
+#define MEMO_HPP
+
+// system includes
+#include <cstddef>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+// module includes
+#include "atom.hpp"
+#include "expression.hpp"
+
+/// entries kept by a MemoTable unless another capacity is given
+const std::size_t MEMO_CAPACITY = 1024;
+
+/*! \class MemoTable
+\brief A bounded least-recently-used map from argument lists to results.
+ */
+class MemoTable {
+public:
+
+  /*! Construct an empty table
+    \param capacity the number of entries kept
+    \param procs the built-in procedures called by the memoized body
+   */
+  MemoTable(std::size_t capacity, const std::vector<Atom> & procs);
+
+  /*! Look up the result of a call
+    \param args the argument values
+    \param result set to the cached result when found
+    \return true on a hit
+   */
+  bool find(const std::vector<Expression> & args, Expression & result);
+
+  /*! Remember the result of a call, evicting the least recently used entry
+    if the table is full
+    \param args the argument values
+    \param result the value of the call
+   */
+  void insert(const std::vector<Expression> & args, const Expression & result);
+
+  /// the built-in procedures called by the memoized body
+  const std::vector<Atom> & procedures() const noexcept;
+
+  /// the number of calls answered from the table
+  std::size_t hits() const noexcept;
+
+  /// the number of calls that had to be evaluated
+  std::size_t misses() const noexcept;
+
+  /// the number of entries held
+  std::size_t size() const noexcept;
+
+private:
+
+  struct Entry {
+    std::size_t hash;
+    std::vector<Expression> args;
+    Expression result;
+  };
+
+  // most recently used first
+  std::list<Entry> entries;
+  std::unordered_multimap<std::size_t, std::list<Entry>::iterator> index;
+
+  std::size_t capacity;
+  std::vector<Atom> procs;
+  std::size_t hit_count;
+  std::size_t miss_count;
+
+  mutable std::mutex mutex;
+
+  std::size_t hash(const std::vector<Expression> & args) const;
+};
+
+#endif
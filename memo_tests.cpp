@@ -0,0 +1,109 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "memo.hpp"
+#include "semantic_error.hpp"
+
+static Expression run(Interpreter & interp, const std::string & program){
+
+  std::istringstream iss(program);
+  REQUIRE(interp.parseStream(iss) == true);
+  return interp.evaluate();
+}
+
+static Expression list_of(double a, double b){
+
+  Expression result(Atom("list"));
+  result.append(Atom(a));
+  result.append(Atom(b));
+  return result;
+}
+
+TEST_CASE( "Test memo table", "[memo]" ) {
+
+  MemoTable table(2, std::vector<Atom>());
+
+  std::vector<Expression> one = {Expression(1.)};
+  std::vector<Expression> two = {Expression(2.)};
+  std::vector<Expression> three = {Expression(3.)};
+
+  Expression result;
+  REQUIRE(!table.find(one, result));
+  table.insert(one, Expression(10.));
+  table.insert(two, Expression(20.));
+
+  REQUIRE(table.find(one, result));
+  REQUIRE(result == Expression(10.));
+
+  INFO("the least recently used entry is evicted");
+  table.insert(three, Expression(30.));
+  REQUIRE(table.size() == 2);
+  REQUIRE(!table.find(two, result));
+  REQUIRE(table.find(one, result));
+  REQUIRE(table.find(three, result));
+
+  REQUIRE(table.hits() == 3);
+  REQUIRE(table.misses() == 2);
+}
+
+TEST_CASE( "Test memoize special form", "[memo]" ) {
+
+  Interpreter interp;
+
+  run(interp, "(define f (memoize (lambda (x) (* x x))))");
+  REQUIRE(run(interp, "(list (f 2) (f 3))") == list_of(4, 9));
+  REQUIRE(run(interp, "(f 2)") == Expression(4.));
+  REQUIRE(run(interp, "(memo-stats f)") == list_of(1, 2));
+
+  INFO("calls made by map use the memo");
+  run(interp, "(map f (list 2 3))");
+  REQUIRE(run(interp, "(memo-stats f)") == list_of(3, 2));
+
+  INFO("errors");
+  std::vector<std::string> programs = {
+    "(memoize 1)",
+    "(memoize (lambda (x) (+ x y)))",
+    "(memo-stats (lambda (x) x))",
+    "(memoize f f)",
+  };
+  for(auto & program : programs){
+    INFO(program);
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss) == true);
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+}
+
+TEST_CASE( "Test auto-memoize", "[memo]" ) {
+
+  for(auto mode : {Interpreter::TreeWalk, Interpreter::Bytecode}){
+    Interpreter interp;
+    interp.setMode(mode);
+    interp.setAutoMemoize(true);
+
+    run(interp, "(define f (lambda (x) (+ x 1)))");
+    run(interp, "(define g (lambda (x) (+ x y)))");
+    REQUIRE(run(interp, "(+ (f 1) (f 1))") == Expression(4.));
+    REQUIRE(run(interp, "(memo-stats f)") == list_of(1, 1));
+
+    INFO("impure lambdas are left alone");
+    std::istringstream iss("(memo-stats g)");
+    REQUIRE(interp.parseStream(iss) == true);
+    REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  }
+
+  INFO("a parameter may not shadow a procedure the memo depends on");
+  Interpreter interp;
+  interp.setAutoMemoize(true);
+  run(interp, "(define f (lambda (x) (+ x 1)))");
+  std::istringstream iss("(define g (lambda (+) (f 1)))");
+  REQUIRE(interp.parseStream(iss) == true);
+  REQUIRE_THROWS_AS(interp.evaluate(), SemanticError);
+  REQUIRE(run(interp, "(f 1)") == Expression(2.));
+  REQUIRE(run(interp, "(f 1)") == Expression(2.));
+  REQUIRE(run(interp, "(memo-stats f)") == list_of(1, 1));
+}
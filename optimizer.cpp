@@ -0,0 +1,110 @@
+#include "optimizer.hpp"
+
+// system includes
+#include <vector>
+
+// module includes
+#include "semantic_error.hpp"
+
+Expression ConstantFolder::fold(const Expression & program, const Environment & env){
+
+  collect(program);
+  Expression folded;
+  return fold_node(program, env, folded) ? folded : program;
+}
+
+void ConstantFolder::collect(const Expression & exp){
+
+  if((exp.form() == Expression::DefineForm) && (exp.tailConstBegin() != exp.tailConstEnd())){
+    bound.insert(exp.tailConstBegin()->head().symbolId());
+  }
+  else if((exp.form() == Expression::LambdaForm) && (exp.tailConstBegin() != exp.tailConstEnd())){
+    const Expression & params = *exp.tailConstBegin();
+    bound.insert(params.head().symbolId());
+    for(auto p = params.tailConstBegin(); p != params.tailConstEnd(); ++p){
+      bound.insert(p->head().symbolId());
+    }
+  }
+
+  for(auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e){
+    collect(*e);
+  }
+}
+
+bool ConstantFolder::is_bound(const Atom & sym) const{
+  return bound.find(sym.symbolId()) != bound.end();
+}
+
+bool ConstantFolder::is_constant(const Expression & exp) const{
+  // the head is tested first, so a packed list is not expanded to find it
+  // has a tail
+  return (exp.isHeadNumber() || exp.isHeadComplex()) && (exp.tailConstBegin() == exp.tailConstEnd());
+}
+
+bool ConstantFolder::fold_node(const Expression & exp, const Environment & env,
+                               Expression & folded) const{
+
+  const Atom & head = exp.head();
+  Expression::Form form = exp.form();
+
+  if(exp.tailConstBegin() == exp.tailConstEnd()){
+    // a reference to an untouched default constant
+    if((form == Expression::NoForm) && head.isSymbol() && !is_bound(head) &&
+       defaults.is_exp(head) && env.is_exp(head) && (env.get_exp(head) == defaults.get_exp(head))){
+      folded = env.get_exp(head);
+      return true;
+    }
+    return false;
+  }
+
+  // apply passes its list unevaluated, properties keep their value
+  // expressions, leave those subtrees alone. A lambda body may run after a
+  // later program has bound any name in it, so it is kept as written.
+  if((form == Expression::ApplyForm) || (form == Expression::SetPropertyForm) ||
+     (form == Expression::GetPropertyForm) || (form == Expression::LambdaForm)){
+    return false;
+  }
+
+  // the tail is only rebuilt once an operand folds, so an unchanged
+  // subtree keeps sharing it
+  Expression result(head);
+  bool changed = false;
+  bool all_constant = true;
+  for(auto e = exp.tailConstBegin(); e != exp.tailConstEnd(); ++e){
+    // the name of a define and the procedure given to map are not evaluated
+    bool operand = !(((form == Expression::DefineForm) || (form == Expression::MapForm)) &&
+                     (e == exp.tailConstBegin()));
+    Expression value;
+    bool folded_operand = operand && fold_node(*e, env, value);
+    all_constant = all_constant && is_constant(folded_operand ? value : *e);
+    if(folded_operand && !changed){
+      for(auto prev = exp.tailConstBegin(); prev != e; ++prev){
+        result.appendExpression(*prev);
+      }
+      changed = true;
+    }
+    if(changed){
+      result.appendExpression(folded_operand ? std::move(value) : *e);
+    }
+  }
+
+  const Expression & args = changed ? result : exp;
+  if((form == Expression::NoForm) && all_constant && !is_bound(head) && env.is_proc(head)){
+    std::vector<Expression> values(args.tailConstBegin(), args.tailConstEnd());
+    try{
+      Expression value = env.get_proc(head)(values);
+      if(is_constant(value)){
+        folded = value;
+        return true;
+      }
+    }
+    catch(const SemanticError &){
+      // left for evaluation to report
+    }
+  }
+
+  if(changed){
+    folded = std::move(result);
+  }
+  return changed;
+}
@@ -0,0 +1,52 @@
+/*! \file optimizer.hpp
+Defines the constant folding pass run over a parsed AST before evaluation.
+
+Calls to built-in procedures whose arguments are all numeric constants are
+replaced by their value, and references to the constants of the default
+environment (pi, e, I) are replaced by the constant. A name is never
+inlined once a define or a lambda parameter has bound it, in this program
+or in any earlier one folded by the same ConstantFolder, since scoping is
+dynamic and any such binding can shadow it at run time. A lambda is left as
+written, since its body may run after a later program has bound any name
+in it. A subtree with nothing to fold keeps sharing its tail.
+ */
+#ifndef OPTIMIZER_HPP
+#define OPTIMIZER_HPP
+
+// system includes
+#include <cstddef>
+#include <unordered_set>
+
+// module includes
+#include "atom.hpp"
+#include "environment.hpp"
+#include "expression.hpp"
+
+/*! \class ConstantFolder
+\brief Folds constant subtrees of the programs evaluated in one Environment.
+ */
+class ConstantFolder {
+public:
+
+  /*! Fold a program
+    \param program the parsed program
+    \param env the environment the program will be evaluated in
+    \return the folded program, evaluating to the same result as program
+   */
+  Expression fold(const Expression & program, const Environment & env);
+
+private:
+
+  // the default environment, holding the values constants are inlined from
+  Environment defaults;
+
+  // symbol ids of every name bound by a define or a lambda parameter
+  std::unordered_set<std::size_t> bound;
+
+  void collect(const Expression & exp);
+  bool is_bound(const Atom & sym) const;
+  bool is_constant(const Expression & exp) const;
+  bool fold_node(const Expression & exp, const Environment & env, Expression & folded) const;
+};
+
+#endif
@@ -0,0 +1,163 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "optimizer.hpp"
+#include "parse.hpp"
+
+static Expression parse_program(const std::string & program){
+
+  std::istringstream iss(program);
+  return parse(tokenize(iss));
+}
+
+// evaluate programs one after another in one interpreter, returning the
+// result of the last
+static Expression run_all(const std::vector<std::string> & programs,
+                          Interpreter::EvalMode mode){
+
+  Interpreter interp;
+  interp.setMode(mode);
+
+  Expression result;
+  for(auto & program : programs){
+    std::istringstream iss(program);
+    REQUIRE(interp.parseStream(iss) == true);
+    result = interp.evaluate();
+  }
+  return result;
+}
+
+static Expression run(const std::string & program){
+
+  std::istringstream iss(program);
+
+  Interpreter interp;
+  REQUIRE(interp.parseStream(iss) == true);
+
+  return interp.evaluate();
+}
+
+TEST_CASE( "Test folding constant calls", "[optimizer]" ) {
+
+  Environment env;
+  ConstantFolder folder;
+
+  {
+    INFO("nested builtin calls on literals");
+    Expression folded = folder.fold(parse_program("(+ 1 (* 2 3))"), env);
+    REQUIRE(folded == Expression(7.));
+  }
+
+  {
+    INFO("default constants are inlined");
+    Expression folded = folder.fold(parse_program("(* 2 pi)"), env);
+    REQUIRE(folded == Expression(2 * std::atan2(0, -1)));
+  }
+
+  {
+    INFO("calls inside a lambda body are not folded");
+    Expression program = parse_program("(define f (lambda (x) (+ x (* 2 3))))");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+
+  {
+    INFO("constants inside a lambda body are not inlined");
+    Expression program = parse_program("(lambda (x) (* x pi))");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+
+  {
+    INFO("a program with nothing to fold keeps sharing its tail");
+    Expression program = parse_program("(begin (define f (lambda (x) (+ x 1))) (f 2))");
+    Expression folded = folder.fold(program, env);
+    REQUIRE(&*folded.tailConstBegin() == &*program.tailConstBegin());
+  }
+
+  {
+    INFO("only the operands that fold are replaced");
+    Expression program = parse_program("(list (+ 1 2) (lambda (x) (* 2 3)))");
+    Expression expected = parse_program("(list 3 (lambda (x) (* 2 3)))");
+    REQUIRE(folder.fold(program, env) == expected);
+  }
+
+  {
+    INFO("calls that raise an error are left for evaluation");
+    Expression program = parse_program("(+ 1 (first (list)))");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+
+  {
+    INFO("the list passed to apply is not evaluated");
+    Expression program = parse_program("(apply + (list 1 (+ 1 2)))");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+}
+
+TEST_CASE( "Test rebound constants are not folded", "[optimizer]" ) {
+
+  {
+    INFO("defined in the same program");
+    Environment env;
+    ConstantFolder folder;
+    Expression program = parse_program("(begin (define pi 3) (* 2 pi))");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+
+  {
+    INFO("defined by an earlier program");
+    Environment env;
+    ConstantFolder folder;
+    folder.fold(parse_program("(define e 3)"), env);
+    Expression program = parse_program("(+ e 1)");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+
+  {
+    INFO("shadowed by a lambda parameter");
+    Environment env;
+    ConstantFolder folder;
+    folder.fold(parse_program("(define f (lambda (pi g) (g)))"), env);
+    Expression program = parse_program("(define g (lambda () (* 2 pi)))");
+    REQUIRE(folder.fold(program, env) == program);
+  }
+
+  std::vector<std::string> programs = {
+    "(begin (define pi 3) (* 2 pi))",
+    "(begin (define f (lambda (pi) (* 2 pi))) (f 4))",
+    "(begin (define g (lambda (x) (+ x I))) (define f (lambda (I) (g 1))) (f 2))",
+  };
+  std::vector<Expression> expected = {
+    Expression(6.),
+    Expression(8.),
+    Expression(3.),
+  };
+
+  for(std::size_t i = 0; i < programs.size(); ++i){
+    INFO(programs[i]);
+    REQUIRE(run(programs[i]) == expected[i]);
+  }
+
+  for(auto mode : {Interpreter::TreeWalk, Interpreter::Bytecode}){
+    INFO("rebound after the lambda is defined");
+    REQUIRE(run_all({"(define g (lambda (x) (* x pi)))", "(define pi 3)", "(g 1)"}, mode) ==
+            Expression(3.));
+
+    INFO("shadowed by the caller's parameter");
+    REQUIRE(run_all({"(define g (lambda (x) (* x pi)))", "(define f (lambda (pi) (g 1)))",
+                     "(f 4)"}, mode) == Expression(4.));
+
+    INFO("the defined lambda keeps its body as written");
+    std::ostringstream out;
+    out << run_all({"(define f (lambda (x) (+ x (* 2 3))))"}, mode);
+    REQUIRE(out.str() == "(((x)) (+ (x) (* (2) (3))))");
+
+    INFO("the defined lambda keeps the name");
+    REQUIRE(run_all({"(define g (lambda (x) (* x pi)))", "(begin g)"}, mode) ==
+            run_all({"(lambda (x) (* x pi))"}, mode));
+  }
+}
@@ -1,12 +1,13 @@
 #include "parse.hpp"
 
 #include <stack>
+#include <vector>
 
 bool setHead(Expression &exp, const Token &token) {
 
   Atom a(token);
 
-  exp.head() = a;
+  exp.setHead(a);
 
   return !a.isNone();
 }
@@ -20,6 +21,40 @@ bool append(Expression *exp, const Token &token) {
   return !a.isNone();
 }
 
+// the number of tail expressions of each list, by the index of its head
+// token, so every tail is allocated once at its final size
+static std::vector<std::size_t> count_tails(const TokenSequenceType &tokens) {
+
+  std::vector<std::size_t> counts(tokens.size(), 0);
+  std::vector<std::size_t> heads;
+
+  bool athead = false;
+  std::size_t index = 0;
+  for (auto &t : tokens) {
+    if (t.type() == Token::OPEN) {
+      athead = true;
+    } else if (t.type() == Token::CLOSE) {
+      if (!heads.empty())
+        heads.pop_back();
+    } else {
+      if (!heads.empty())
+        counts[heads.back()] += 1;
+      if (athead)
+        heads.push_back(index);
+      athead = false;
+    }
+    index += 1;
+  }
+
+  return counts;
+}
+
+Expression parse(const TokenSequenceType &tokens, NodeArena &arena) noexcept {
+
+  NodeArena::Scope scope(arena);
+  return parse(tokens);
+}
+
 Expression parse(const TokenSequenceType &tokens) noexcept {
 
   Expression ast;
@@ -28,6 +63,8 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
   if (tokens.empty())
     return Expression();
 
+  std::vector<std::size_t> tails = count_tails(tokens);
+
   bool athead = false;
 
   // stack tracks the last node created
@@ -56,6 +93,7 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
           if (!setHead(ast, t)) {
             return Expression();
           }
+          ast.reserve(tails[num_tokens_seen]);
           stack.push(&ast);
         } else {
           if (stack.empty()) {
@@ -66,6 +104,7 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
             return Expression();
           }
           stack.push(stack.top()->tail());
+          stack.top()->reserve(tails[num_tokens_seen]);
         }
         athead = false;
       } else {
@@ -87,3 +126,98 @@ Expression parse(const TokenSequenceType &tokens) noexcept {
 
   return Expression();
 };
+
+// a list being read by parse_source: its head, and the elements read so far,
+// moved into its tail once their number is known
+struct OpenList {
+  Expression node;
+  std::vector<Expression> items;
+};
+
+// reads the tokens straight from the characters, by the same rules as the
+// parse of a token sequence, so the same programs are accepted
+static Expression parse_source(const char *data, std::size_t size) {
+
+  // the lists being read, outermost first. Entries past depth are kept so
+  // their item vectors are reused by later lists
+  std::vector<OpenList> lists;
+  std::size_t depth = 0;
+
+  Expression ast;
+  bool any = false;
+  bool done = false;
+  bool athead = false;
+
+  std::size_t position = 0;
+  TokenView t;
+  while (next_token(data, size, position, t)) {
+
+    // the first list is complete, nothing may follow it
+    if (done) {
+      return Expression();
+    }
+    any = true;
+
+    if (t.type == Token::OPEN) {
+      athead = true;
+    } else if (t.type == Token::CLOSE) {
+      if (depth == 0) {
+        return Expression();
+      }
+
+      OpenList &list = lists[depth - 1];
+      list.node.reserve(list.items.size());
+      for (auto &item : list.items) {
+        list.node.appendExpression(std::move(item));
+      }
+      list.items.clear();
+      depth -= 1;
+
+      if (depth == 0) {
+        ast = std::move(list.node);
+        done = true;
+      } else {
+        lists[depth - 1].items.push_back(std::move(list.node));
+      }
+    } else {
+
+      Atom a(data + t.offset, t.length);
+      if (a.isNone()) {
+        return Expression();
+      }
+
+      if (athead) {
+        if (depth == lists.size()) {
+          lists.emplace_back();
+        }
+        lists[depth].node = Expression();
+        lists[depth].node.setHead(a);
+        depth += 1;
+        athead = false;
+      } else {
+        if (depth == 0) {
+          return Expression();
+        }
+        lists[depth - 1].items.emplace_back(a);
+      }
+    }
+  }
+
+  if (!any || depth != 0) {
+    return Expression();
+  }
+
+  return ast;
+}
+
+Expression parse(const char *data, std::size_t size, NodeArena &arena) noexcept {
+
+  NodeArena::Scope scope(arena);
+  return parse(data, size);
+}
+
+Expression parse(const char *data, std::size_t size) noexcept {
+
+  return parse_source(data, size);
+}
+
@@ -4,6 +4,7 @@ Defines the parse function.
 #ifndef PARSE_HPP
 #define PARSE_HPP
 
+#include "arena.hpp"
 #include "token.hpp"
 #include "expression.hpp"
 
@@ -15,4 +16,38 @@ Defines the parse function.
  */
 Expression parse(const TokenSequenceType & tokens) noexcept;
 
+/*! \fn parse
+\brief parse a sequence of tokens into an expression, allocating its nodes
+from an arena
+
+\param tokens, the input token sequence
+\param arena, the arena to allocate from, see NodeArena for how long the
+nodes remain valid
+\returns the expression resulting from parsing or the None Expression on failure
+ */
+Expression parse(const TokenSequenceType & tokens, NodeArena & arena) noexcept;
+
+/*! \fn parse
+\brief parse the characters of a program into an expression in one pass
+
+Tokens are read with next_token as the parser needs them, so no token
+sequence is built. The same programs are accepted as by the other overloads.
+
+\param data, the first character
+\param size, the number of characters
+\returns the expression resulting from parsing or the None Expression on failure
+ */
+Expression parse(const char * data, std::size_t size) noexcept;
+
+/*! \fn parse
+\brief parse the characters of a program into an expression in one pass,
+allocating its nodes from an arena
+
+\param data, the first character
+\param size, the number of characters
+\param arena, the arena to allocate from
+\returns the expression resulting from parsing or the None Expression on failure
+ */
+Expression parse(const char * data, std::size_t size, NodeArena & arena) noexcept;
+
 #endif
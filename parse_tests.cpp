@@ -57,3 +57,31 @@ TEST_CASE( "Test empty parens", "[parse]" ) {
   REQUIRE(parse(tokens) == Expression());
 }
 
+
+TEST_CASE( "Test parser straight from characters", "[parse]" ) {
+
+  std::vector<std::string> programs = {
+    "(begin (define r 10) (* pi (* r r)))",
+    "(list \"a b\" 1 -2.5e1) ; trailing comment",
+    "((begin (+ 1))))))",
+    "(define a 1.2abc)",
+    "+ 1 2",
+    "()",
+    "(a ())",
+    "((a b)",
+    "(a b) (c d)",
+    "",
+    "; only a comment"
+  };
+
+  for(auto & program : programs){
+    INFO(program);
+    std::istringstream iss(program);
+    Expression expected = parse(tokenize(iss));
+    Expression exp = parse(program.data(), program.size());
+    REQUIRE(exp.identical(expected));
+  }
+
+  std::string program = "(begin (define r 10) (* pi (* r r)))";
+  REQUIRE(parse(program.data(), program.size()) != Expression());
+}
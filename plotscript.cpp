@@ -7,11 +7,16 @@
 #include "interpreter.hpp"
 #include "semantic_error.hpp"
 #include "startup_config.hpp"
-#include <environment.hpp>
-#include <message_queue.hpp>
+#include "environment.hpp"
+#include "message_queue.hpp"
+#include "simd.hpp"
+#include "ast_cache.hpp"
+#include "reader.hpp"
+#include "source.hpp"
 #include <thread>
 #include <queue>
 #include <mutex>
+#include <vector>
 #include <signal.h>
 #include <csignal>
 //#include "message_queue.hpp"
@@ -27,6 +32,13 @@
 // Cntl-C has been pressed by not reset by the REPL code.
 volatile sig_atomic_t global_status_flag = 0;
 
+// the evaluation engine selected on the command line
+Interpreter::EvalMode eval_mode = Interpreter::TreeWalk;
+bool auto_memoize = false;
+
+// evaluate the top-level forms of a program one at a time as they are read
+bool stream_forms = false;
+
 // *****************************************************************************
 // install a signal handler for Cntl-C on Windows
 // *****************************************************************************
@@ -123,11 +135,17 @@ void info(const std::string & err_str) {
 	std::cout << "Info: " << err_str << std::endl;
 }
 
-int eval_from_stream(std::istream & stream, std::string filename) {
+// set up an interpreter as selected on the command line
+void configure(Interpreter & interp) {
 
-	Interpreter interp;
+	interp.setMode(eval_mode);
+	interp.setAutoMemoize(auto_memoize);
+}
+
+// evaluate the program parsed into interp, or report that it could not be
+int eval_parsed(Interpreter & interp, bool parsed, std::string filename) {
 
-	if (!interp.parseStream(stream)) {
+	if (!parsed) {
 		error("Invalid Program. Could not parse.");
 		return EXIT_FAILURE;
 	}
@@ -152,20 +170,76 @@ int eval_from_stream(std::istream & stream, std::string filename) {
 
 }
 
+// evaluate each top-level form as soon as it has been read, printing its result
+int eval_forms(std::istream & stream, std::string filename) {
+
+	Interpreter interp;
+	configure(interp);
+
+	FormReader reader(stream);
+	while (reader.next()) {
+		if (!interp.parseSource(reader.data(), reader.size())) {
+			error("Invalid Program. Could not parse.");
+			return EXIT_FAILURE;
+		}
+		try {
+			Expression exp = interp.evaluate();
+			std::cout << exp << std::endl;
+		}
+		catch (const SemanticError & ex) {
+			std::cerr << ex.what() << std::endl;
+			return EXIT_FAILURE;
+		}
+	}
+	if (filename == STARTUP_FILE)
+	{
+		Interpreter copy_interp = interp;
+		return repl(&interp, copy_interp);
+	}
+	else
+		return EXIT_SUCCESS;
+}
+
+int eval_from_stream(std::istream & stream, std::string filename) {
+
+	if (stream_forms) {
+		return eval_forms(stream, filename);
+	}
+
+	Interpreter interp;
+	configure(interp);
+
+	return eval_parsed(interp, interp.parseStream(stream), filename);
+}
+
 
 int eval_from_file(std::string filename) {
 
-	std::ifstream ifs(filename);
+	if (stream_forms) {
+		std::ifstream ifs(filename);
 
-	if (!ifs) {
+		if (!ifs) {
+			error("Could not open file for reading.");
+			return EXIT_FAILURE;
+		}
+		return eval_forms(ifs, filename);
+	}
+
+	// the file is mapped rather than streamed, see SourceBuffer
+	SourceBuffer source;
+
+	if (!source.open(filename)) {
 		error("Could not open file for reading.");
 		return EXIT_FAILURE;
 	}
 
-	//repl();
+	// parsed programs are cached when PLOTSCRIPT_CACHE_DIR is set
+	AstCache cache = AstCache::fromEnvironment();
 
+	Interpreter interp;
+	configure(interp);
 
-	return eval_from_stream(ifs, filename);
+	return eval_parsed(interp, interp.parseSource(source, cache), filename);
 }
 
 int eval_from_command(std::string argexp) {
@@ -353,12 +427,34 @@ int main(int argc, char *argv[])
 	
 	
 
-	if (argc == 2) {
-		return eval_from_file(argv[1]);
+	// leading options, the remaining arguments are handled as before
+	std::vector<std::string> args(argv, argv + argc);
+	while (args.size() > 1 && args[1].compare(0, 2, "--") == 0) {
+		if (args[1] == "--bytecode") {
+			eval_mode = Interpreter::Bytecode;
+		}
+		else if (args[1] == "--auto-memoize") {
+			auto_memoize = true;
+		}
+		else if (args[1] == "--stream") {
+			stream_forms = true;
+		}
+		else if (args[1] == "--fast-math") {
+			set_math_accuracy(FastMath);
+		}
+		else {
+			error("Unknown option " + args[1]);
+			return EXIT_FAILURE;
+		}
+		args.erase(args.begin() + 1);
+	}
+
+	if (args.size() == 2) {
+		return eval_from_file(args[1]);
 	}
-	else if (argc == 3) {
-		if (std::string(argv[1]) == "-e") {
-			return eval_from_command(argv[2]);
+	else if (args.size() == 3) {
+		if (args[1] == "-e") {
+			return eval_from_command(args[2]);
 		}
 		else {
 			error("Incorrect number of command line arguments.");
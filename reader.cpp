@@ -0,0 +1,89 @@
+#include "reader.hpp"
+
+// module includes
+#include "token.hpp"
+
+FormReader::FormReader(std::istream & input, std::size_t chunk):
+  m_input(input), m_chunk(chunk == 0 ? 1 : chunk), m_eof(false), m_begin(0), m_end(0){}
+
+void FormReader::fill(std::size_t keep){
+
+  m_buffer.erase(0, keep);
+
+  // take what the stream already has, and block for a character only when
+  // it has none, so a form is returned as soon as its last character arrives
+  std::size_t old_size = m_buffer.size();
+  m_buffer.resize(old_size + m_chunk);
+  std::size_t count = static_cast<std::size_t>(m_input.readsome(&m_buffer[old_size], m_chunk));
+  if(count == 0){
+    m_input.read(&m_buffer[old_size], 1);
+    count = static_cast<std::size_t>(m_input.gcount());
+    if(count == 1){
+      count += static_cast<std::size_t>(m_input.readsome(&m_buffer[old_size + 1], m_chunk - 1));
+    }
+  }
+  m_buffer.resize(old_size + count);
+
+  if(count == 0){
+    m_eof = true;
+  }
+}
+
+bool FormReader::next(){
+
+  // the open lists of the form, and where scanning resumes
+  std::size_t depth = 0;
+  std::size_t position = m_end;
+  bool started = false;
+
+  while(true){
+    std::size_t before = position;
+    TokenView token;
+    bool found = next_token(m_buffer.data(), m_buffer.size(), position, token);
+
+    // a string token or comment at the end may continue in the next chunk,
+    // so scan it again once that has been read
+    if(!m_eof && (!found || (token.type == Token::STRING && position == m_buffer.size()))){
+      std::size_t keep = started ? m_begin : before;
+      fill(keep);
+      position = before - keep;
+      m_begin -= started ? keep : 0;
+      continue;
+    }
+
+    if(!found){
+      m_end = m_buffer.size();
+      if(!started){
+	m_begin = m_end;
+      }
+      return started;
+    }
+
+    if(!started){
+      started = true;
+      m_begin = token.offset;
+    }
+
+    if(token.type == Token::OPEN){
+      depth += 1;
+    }
+    else if(token.type == Token::CLOSE && depth > 0){
+      depth -= 1;
+    }
+
+    if(depth == 0){
+      m_end = token.offset + token.length;
+      return true;
+    }
+  }
+}
+
+const char * FormReader::data() const noexcept{
+
+  return m_buffer.data() + m_begin;
+}
+
+std::size_t FormReader::size() const noexcept{
+
+  return m_end - m_begin;
+}
@@ -0,0 +1,67 @@
+/*! \file reader.hpp
+Defines the reader that splits a stream into top-level forms, so a program
+of many forms can be evaluated one form at a time as it arrives.
+ */
+#ifndef READER_HPP
+#define READER_HPP
+
+// system includes
+#include <cstddef>
+#include <istream>
+#include <string>
+
+/// the most characters a FormReader reads at a time unless another is given
+const std::size_t READ_CHUNK = 64 * 1024;
+
+/*! \class FormReader
+\brief Reads the top-level forms of a stream one at a time.
+
+A form is a parenthesized list, ending at the close matching its open, or
+any other single token. Input is read as forms need it, up to a chunk of
+whatever the stream has available, waiting only when it has nothing, so a
+form arriving on a pipe is returned once it is complete. Characters are
+dropped once the form holding them has been read, so memory is bounded by
+the largest form rather than the stream.
+
+A form is only split out, not parsed, so a malformed one is returned like
+any other and rejected by the parser. A list still open at the end of the
+stream runs to the end.
+ */
+class FormReader {
+public:
+
+  /*! Construct a reader
+    \param input the stream to read, until end of file
+    \param chunk the most characters to read at a time
+   */
+  explicit FormReader(std::istream & input, std::size_t chunk = READ_CHUNK);
+
+  /*! Read the next form
+    \return false if only whitespace and comments remain
+   */
+  bool next();
+
+  /// the first character of the form, valid until the next call to next
+  const char * data() const noexcept;
+
+  /// the number of characters in the form
+  std::size_t size() const noexcept;
+
+private:
+
+  // drop the characters before keep and append the available input
+  void fill(std::size_t keep);
+
+  std::istream & m_input;
+  std::size_t m_chunk;
+  bool m_eof;
+
+  // the unread input, starting with the current form
+  std::string m_buffer;
+
+  // the current form within the buffer
+  std::size_t m_begin;
+  std::size_t m_end;
+};
+
+#endif
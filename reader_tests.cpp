@@ -0,0 +1,104 @@
+#include "catch.hpp"
+
+#include <sstream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "reader.hpp"
+
+// the forms of a program, read chunk characters at a time
+static std::vector<std::string> forms(const std::string & program, std::size_t chunk){
+
+  std::istringstream iss(program);
+  FormReader reader(iss, chunk);
+
+  std::vector<std::string> result;
+  while(reader.next()){
+    result.emplace_back(reader.data(), reader.size());
+  }
+  return result;
+}
+
+TEST_CASE( "Test reading top-level forms", "[reader]" ) {
+
+  std::string program = "; a program\n(define a 1)\n(define s \"(not ; a list\")"
+    "  (+ a\n ; nested\n 2) atom ) (begin (list (list 1)))";
+
+  std::vector<std::string> expected = {"(define a 1)", "(define s \"(not ; a list\")",
+				       "(+ a\n ; nested\n 2)", "atom", ")",
+				       "(begin (list (list 1)))"};
+
+  // every chunk size splits the tokens differently
+  for(std::size_t chunk : {1, 2, 3, 7, 64, 4096}){
+    INFO(chunk);
+    REQUIRE(forms(program, chunk) == expected);
+  }
+
+  REQUIRE(forms("", 4).empty());
+  REQUIRE(forms("  ; only a comment", 4).empty());
+  REQUIRE(forms("(a (b", 2) == std::vector<std::string>{"(a (b"});
+}
+
+// a stream buffer that hands out its input one piece per underflow, as a
+// pipe does as writes arrive, counting the pieces taken
+class PieceBuffer : public std::streambuf {
+public:
+  explicit PieceBuffer(const std::vector<std::string> & pieces): m_pieces(pieces), m_taken(0){}
+
+  std::size_t taken() const { return m_taken; }
+
+protected:
+  int_type underflow() override{
+    if(gptr() < egptr()) return traits_type::to_int_type(*gptr());
+    if(m_taken == m_pieces.size()) return traits_type::eof();
+    std::string & piece = m_pieces[m_taken++];
+    setg(&piece[0], &piece[0], &piece[0] + piece.size());
+    return traits_type::to_int_type(*gptr());
+  }
+
+private:
+  std::vector<std::string> m_pieces;
+  std::size_t m_taken;
+};
+
+TEST_CASE( "Test reading forms as they arrive", "[reader]" ) {
+
+  PieceBuffer pieces({"(define a 1)\n(+ a", " 2)\n", "(* a 3)\n"});
+  std::istream input(&pieces);
+  FormReader reader(input);
+
+  INFO("a form is returned without waiting for the rest of the chunk");
+  REQUIRE(reader.next());
+  REQUIRE(std::string(reader.data(), reader.size()) == "(define a 1)");
+  REQUIRE(pieces.taken() == 1);
+
+  INFO("a form split across pieces waits for the piece ending it");
+  REQUIRE(reader.next());
+  REQUIRE(std::string(reader.data(), reader.size()) == "(+ a 2)");
+  REQUIRE(pieces.taken() == 2);
+
+  REQUIRE(reader.next());
+  REQUIRE(std::string(reader.data(), reader.size()) == "(* a 3)");
+  REQUIRE(pieces.taken() == 3);
+  REQUIRE(!reader.next());
+}
+
+TEST_CASE( "Test evaluating forms one at a time", "[reader]" ) {
+
+  std::istringstream iss("(define a 1) (define b (+ a 1)) (* a b 10)");
+  FormReader reader(iss, 5);
+  Interpreter interp;
+
+  std::vector<Expression> results;
+  while(reader.next()){
+    REQUIRE(interp.parseSource(reader.data(), reader.size()));
+    results.push_back(interp.evaluate());
+  }
+
+  REQUIRE(results.size() == 3);
+  REQUIRE(results[0] == Expression(1.));
+  REQUIRE(results[1] == Expression(2.));
+  REQUIRE(results[2] == Expression(20.));
+}
@@ -0,0 +1,618 @@
+#include "simd.hpp"
+
+// system includes
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define SIMD_X86 1
+#include <immintrin.h>
+#define TARGET(isa) __attribute__((target(isa)))
+#endif
+
+SimdLevel simd_supported() noexcept{
+
+  static const SimdLevel supported = [](){
+#ifdef SIMD_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")) return SimdAVX2;
+    if(__builtin_cpu_supports("sse2")) return SimdSSE2;
+#endif
+    return SimdScalar;
+  }();
+  return supported;
+}
+
+// the level selected by set_simd_level
+static std::atomic<SimdLevel> & selected(){
+  static std::atomic<SimdLevel> level(simd_supported());
+  return level;
+}
+
+SimdLevel simd_level() noexcept{
+  return selected().load(std::memory_order_relaxed);
+}
+
+void set_simd_level(SimdLevel level) noexcept{
+  selected().store(level < simd_supported() ? level : simd_supported(),
+		   std::memory_order_relaxed);
+}
+
+// the accuracy selected by set_math_accuracy
+static std::atomic<MathAccuracy> accuracy(StrictMath);
+
+MathAccuracy math_accuracy() noexcept{
+  return accuracy.load(std::memory_order_relaxed);
+}
+
+void set_math_accuracy(MathAccuracy mode) noexcept{
+  accuracy.store(mode, std::memory_order_relaxed);
+}
+
+// the functions one element at a time with std::, which the kernels below
+// fall back to outside the domain they handle
+template <UnaryOp Op>
+static double unary_std(double x){
+  switch(Op){
+  case SqrtOp: return std::sqrt(x);
+  case SinOp: return std::sin(x);
+  case CosOp: return std::cos(x);
+  case TanOp: return std::tan(x);
+  case ExpOp: return std::exp(x);
+  case LogOp: return std::log(x);
+  }
+  return 0;
+}
+
+template <UnaryOp Op>
+static void unary_scalar(const double * a, double * out, std::size_t n){
+  for(std::size_t i = 0; i < n; ++i){
+    out[i] = unary_std<Op>(a[i]);
+  }
+}
+
+// the operators one element at a time. The vector versions below round
+// the same way, IEEE 754 requires exact rounding of each of them.
+template <BinaryOp Op>
+static inline double apply(double a, double b){
+  switch(Op){
+  case AddOp: return a + b;
+  case SubOp: return a - b;
+  case MulOp: return a * b;
+  case DivOp: return a / b;
+  case PowOp: return std::pow(a, b);
+  }
+  return 0;
+}
+
+template <BinaryOp Op>
+static void binary_scalar(const double * a, bool a_scalar, const double * b, bool b_scalar,
+			  double * out, std::size_t n){
+  for(std::size_t i = 0; i < n; ++i){
+    out[i] = apply<Op>(a_scalar ? *a : a[i], b_scalar ? *b : b[i]);
+  }
+}
+
+#ifdef SIMD_X86
+
+template <BinaryOp Op>
+TARGET("sse2") static inline __m128d apply_sse2(__m128d a, __m128d b){
+  switch(Op){
+  case AddOp: return _mm_add_pd(a, b);
+  case SubOp: return _mm_sub_pd(a, b);
+  case MulOp: return _mm_mul_pd(a, b);
+  default: return _mm_div_pd(a, b);
+  }
+}
+
+template <BinaryOp Op>
+TARGET("sse2") static void binary_sse2(const double * a, bool a_scalar, const double * b, bool b_scalar,
+				       double * out, std::size_t n){
+  const __m128d va = _mm_set1_pd(*a);
+  const __m128d vb = _mm_set1_pd(*b);
+  std::size_t i = 0;
+  for(; i + 2 <= n; i += 2){
+    __m128d x = a_scalar ? va : _mm_loadu_pd(a + i);
+    __m128d y = b_scalar ? vb : _mm_loadu_pd(b + i);
+    _mm_storeu_pd(out + i, apply_sse2<Op>(x, y));
+  }
+  binary_scalar<Op>(a_scalar ? a : a + i, a_scalar, b_scalar ? b : b + i, b_scalar, out + i, n - i);
+}
+
+template <BinaryOp Op>
+TARGET("avx2") static inline __m256d apply_avx2(__m256d a, __m256d b){
+  switch(Op){
+  case AddOp: return _mm256_add_pd(a, b);
+  case SubOp: return _mm256_sub_pd(a, b);
+  case MulOp: return _mm256_mul_pd(a, b);
+  default: return _mm256_div_pd(a, b);
+  }
+}
+
+template <BinaryOp Op>
+TARGET("avx2") static void binary_avx2(const double * a, bool a_scalar, const double * b, bool b_scalar,
+				       double * out, std::size_t n){
+  const __m256d va = _mm256_set1_pd(*a);
+  const __m256d vb = _mm256_set1_pd(*b);
+  std::size_t i = 0;
+  for(; i + 4 <= n; i += 4){
+    __m256d x = a_scalar ? va : _mm256_loadu_pd(a + i);
+    __m256d y = b_scalar ? vb : _mm256_loadu_pd(b + i);
+    _mm256_storeu_pd(out + i, apply_avx2<Op>(x, y));
+  }
+  binary_scalar<Op>(a_scalar ? a : a + i, a_scalar, b_scalar ? b : b + i, b_scalar, out + i, n - i);
+}
+
+TARGET("sse2") static void sqrt_sse2(const double * a, double * out, std::size_t n){
+  std::size_t i = 0;
+  for(; i + 2 <= n; i += 2){
+    _mm_storeu_pd(out + i, _mm_sqrt_pd(_mm_loadu_pd(a + i)));
+  }
+  for(; i < n; ++i){
+    out[i] = std::sqrt(a[i]);
+  }
+}
+
+TARGET("avx2") static void sqrt_avx2(const double * a, double * out, std::size_t n){
+  std::size_t i = 0;
+  for(; i + 4 <= n; i += 4){
+    _mm256_storeu_pd(out + i, _mm256_sqrt_pd(_mm256_loadu_pd(a + i)));
+  }
+  for(; i < n; ++i){
+    out[i] = std::sqrt(a[i]);
+  }
+}
+
+// The transcendental kernels are written once over GCC vector types and
+// inlined into a function per instruction set. Each reduces the argument
+// to a small interval and evaluates a polynomial there, after fdlibm.
+// Lanes the reduction does not cover, e.g. NaN, infinities, very large
+// arguments and results that under- or overflow, are recomputed with std::.
+
+#define ALWAYS_INLINE __attribute__((always_inline)) inline
+
+// the kernels pass vectors by value, which is fine as they are always
+// inlined into a function compiled for the instruction set
+#pragma GCC diagnostic ignored "-Wpsabi"
+
+typedef double Vec2 __attribute__((vector_size(16)));
+typedef std::uint64_t Bits2 __attribute__((vector_size(16)));
+typedef double Vec4 __attribute__((vector_size(32)));
+typedef std::uint64_t Bits4 __attribute__((vector_size(32)));
+
+// adding and subtracting 1.5 * 2^52 rounds to the nearest integer, and the
+// sum holds the integer in its low bits
+static const double ROUND = 6755399441055744.0;
+
+static const double LN2_HI = 6.93147180369123816490e-01; // the top 32 bits of ln 2
+static const double LN2_LO = 1.90821492927058770002e-10;
+static const double INV_LN2 = 1.44269504088896338700e+00;
+
+static const double INV_PIO2 = 6.36619772367581382433e-01;
+static const double PIO2_1 = 1.57079632673412561417e+00;  // the top 33 bits of pi/2
+static const double PIO2_2 = 6.07710050630396597660e-11;  // the next 33 bits
+static const double PIO2_2T = 2.02226624879595063154e-21; // pi/2 - PIO2_1 - PIO2_2
+static const double PIO2_3 = 2.02226624871116645580e-21;  // the next 33 bits
+static const double PIO2_3T = 8.47842766036889956997e-32;
+
+// the largest argument of sin, cos and tan the reduction is exact for
+static const double TRIG_MAX = 5.0e5;
+
+// the largest magnitude of an argument of exp with a normal result
+static const double EXP_MAX = 708.0;
+
+template <typename V>
+ALWAYS_INLINE V splat(double c){
+  return (V){} + c;
+}
+
+template <typename V, typename B>
+ALWAYS_INLINE V abs(V x){
+  return (V)((B)x & 0x7fffffffffffffffULL);
+}
+
+template <typename V, typename B>
+ALWAYS_INLINE V select(B mask, V a, V b){
+  return (V)((mask & (B)a) | (~mask & (B)b));
+}
+
+// the integer nearest to x, as a double and in the low bits of n
+template <typename V, typename B>
+ALWAYS_INLINE V round(V x, B & n){
+  V t = x + ROUND;
+  n = (B)t - (B)splat<V>(ROUND);
+  return t - ROUND;
+}
+
+// e^x, Taylor to degree 13 on |r| <= ln(2)/2, or 10 in fast mode
+template <bool Strict, typename V, typename B>
+ALWAYS_INLINE V exp_kernel(V x, B & bad){
+  bad = ~((B)(x >= -EXP_MAX) & (B)(x <= EXP_MAX));
+  x = select(bad, splat<V>(0), x);
+
+  B n;
+  V k = round<V, B>(x * INV_LN2, n);
+  V r = (x - k * LN2_HI) - k * LN2_LO;
+
+  V p;
+  if(Strict){
+    p = splat<V>(1.0 / 6227020800);
+    p = 1.0 / 479001600 + r * p;
+    p = 1.0 / 39916800 + r * p;
+    p = 1.0 / 3628800 + r * p;
+  }
+  else{
+    p = splat<V>(1.0 / 3628800);
+  }
+  p = 1.0 / 362880 + r * p;
+  p = 1.0 / 40320 + r * p;
+  p = 1.0 / 5040 + r * p;
+  p = 1.0 / 720 + r * p;
+  p = 1.0 / 120 + r * p;
+  p = 1.0 / 24 + r * p;
+  p = 1.0 / 6 + r * p;
+  p = 0.5 + r * p;
+  V y = 1.0 + (r + r * r * p);
+
+  // scale by 2^n, built from its bits
+  return y * (V)((n + 1023) << 52);
+}
+
+// ln x = k ln 2 + ln(1 + f), 1 + f in [sqrt(2)/2, sqrt(2)), with
+// ln(1 + f) = 2 atanh(s), s = f / (2 + f), as a series in s^2
+template <bool Strict, typename V, typename B>
+ALWAYS_INLINE V log_kernel(V x, B & bad){
+  bad = ~((B)(x >= 2.2250738585072014e-308) & (B)(x <= 1.7976931348623157e308));
+  x = select(bad, splat<V>(1), x);
+
+  B bits = (B)x;
+  B e = (bits >> 52) - 1023;
+  V m = (V)((bits & 0x000fffffffffffffULL) | 0x3ff0000000000000ULL);
+  B big = (B)(m > 1.41421356237309504880);
+  m = select(big, m * 0.5, m);
+  e = e - big;
+  V k = (V)(e + (B)splat<V>(ROUND)) - ROUND;
+
+  V f = m - 1.0;
+  V s = f / (2.0 + f);
+  V z = s * s;
+  V R;
+  if(Strict){
+    R = splat<V>(2.0 / 23);
+    R = 2.0 / 21 + z * R;
+    R = 2.0 / 19 + z * R;
+    R = 2.0 / 17 + z * R;
+  }
+  else{
+    R = splat<V>(2.0 / 17);
+  }
+  R = 2.0 / 15 + z * R;
+  R = 2.0 / 13 + z * R;
+  R = 2.0 / 11 + z * R;
+  R = 2.0 / 9 + z * R;
+  R = 2.0 / 7 + z * R;
+  R = 2.0 / 5 + z * R;
+  R = 2.0 / 3 + z * R;
+  R = z * R;
+  V hfsq = 0.5 * f * f;
+  return k * LN2_HI - ((hfsq - (s * (hfsq + R) + k * LN2_LO)) - f);
+}
+
+// a + b as s + e exactly, returning s
+template <typename V>
+ALWAYS_INLINE V two_sum(V a, V b, V & e){
+  V s = a + b;
+  V bb = s - a;
+  e = (a - (s - bb)) + (b - bb);
+  return s;
+}
+
+// x = n pi/2 + r + y with |r| <= pi/4, y the part of the remainder below
+// the precision of r. The products of n and the parts of pi/2 but the
+// last are exact. Strict mode keeps the rounding errors of the differences
+// in y; fast mode rounds each difference, leaving y zero.
+template <bool Strict, typename V, typename B>
+ALWAYS_INLINE V reduce_pio2(V x, B & n, V & y){
+  V k = round<V, B>(x * INV_PIO2, n);
+  V r = x - k * PIO2_1;
+  if(!Strict){
+    y = splat<V>(0);
+    return (r - k * PIO2_2) - k * PIO2_2T;
+  }
+
+  V e1, e2, e3;
+  V t = two_sum(r, -(k * PIO2_2), e1);
+  V u = two_sum(e1, -(k * PIO2_3), e2);
+  t = two_sum(t, u, e3);
+  V tail = e3 + (e2 - k * PIO2_3T);
+  V head = t + tail;
+  y = (t - head) + tail;
+  return head;
+}
+
+// sin(r + y) and cos(r + y) for |r| <= pi/4, minimax polynomials from fdlibm
+template <typename V>
+ALWAYS_INLINE V sin_poly(V x, V y){
+  V z = x * x;
+  V v = z * x;
+  V r = 8.33333333332248946124e-03 + z * (-1.98412698298579493134e-04 +
+	z * (2.75573137070700676789e-06 + z * (-2.50507602534068634195e-08 +
+	z * 1.58969099521155010221e-10)));
+  return x - ((z * (0.5 * y - v * r) - y) - v * -1.66666666666666324348e-01);
+}
+
+template <typename V>
+ALWAYS_INLINE V cos_poly(V x, V y){
+  V z = x * x;
+  V r = z * (4.16666666666666019037e-02 + z * (-1.38888888888741095749e-03 +
+	z * (2.48015872894767294178e-05 + z * (-2.75573143513906633035e-07 +
+	z * (2.08757232129817482790e-09 + z * -1.13596475577881948265e-11)))));
+  V hz = 0.5 * z;
+  V w = 1.0 - hz;
+  return w + (((1.0 - w) - hz) + (z * r - x * y));
+}
+
+// sin x, or cos x = sin(x + pi/2) with Shift 1, choosing the polynomial and
+// sign by the quadrant
+template <bool Strict, int Shift, typename V, typename B>
+ALWAYS_INLINE V sin_kernel(V x, B & bad){
+  bad = ~(B)(abs<V, B>(x) <= TRIG_MAX);
+  x = select(bad, splat<V>(0), x);
+
+  B n;
+  V y;
+  V r = reduce_pio2<Strict, V, B>(x, n, y);
+  n = n + Shift;
+  V v = select((B)((n & 1) == 1), cos_poly(r, y), sin_poly(r, y));
+  return (V)((B)v ^ ((n & 2) << 62));
+}
+
+// tan(x + y) for |x| <= pi/4, or -1/tan(x + y) in the lanes of odd,
+// following fdlibm's __kernel_tan. Near pi/4 it computes tan(pi/4 - x)
+// instead, and the reciprocal is refined so it stays within 1 ulp.
+template <typename V, typename B>
+ALWAYS_INLINE V tan_poly(V x, V y, B odd){
+  const std::uint64_t high = 0xffffffff00000000ULL;
+  V iy = select(odd, splat<V>(-1), splat<V>(1));
+  B negative = (B)x & 0x8000000000000000ULL;
+  B big = (B)(abs<V, B>(x) >= 0.6743316650390625);
+
+  V xa = (V)((B)x ^ negative);
+  V ya = (V)((B)y ^ negative);
+  x = select(big, (7.85398163397448278999e-01 - xa) + (3.06161699786838301793e-17 - ya), x);
+  y = select(big, splat<V>(0), y);
+
+  V z = x * x;
+  V w = z * z;
+  V r = 1.33333333333201242699e-01 + w * (2.18694882948595424599e-02 +
+	w * (3.59207910759131235356e-03 + w * (5.88041240820264096874e-04 +
+	w * (7.81794442939557092300e-05 + w * -1.85586374855275456654e-05))));
+  V v = z * (5.39682539762260521377e-02 + w * (8.86323982359930005737e-03 +
+	w * (1.45620945432529025516e-03 + w * (2.46463134818469906812e-04 +
+	w * (7.14072491382608190305e-05 + w * 2.59073051863633712884e-05)))));
+  V s = z * x;
+  r = y + z * (s * (r + v) + y);
+  r += 3.33333333333334091986e-01 * s;
+  w = x + r;
+
+  V near = iy - 2.0 * (x - (w * w / (w + iy) - r));
+  near = (V)((B)near ^ negative);
+
+  // -1/w, split so the products below are exact
+  V wh = (V)((B)w & high);
+  V lo = r - (wh - x);
+  V a = -1.0 / w;
+  V t = (V)((B)a & high);
+  V recip = t + a * ((1.0 + t * wh) + t * lo);
+
+  return select(big, near, select(odd, recip, w));
+}
+
+// tan x. Fast mode takes the quotient of the sine and cosine of the
+// reduced argument.
+template <bool Strict, typename V, typename B>
+ALWAYS_INLINE V tan_kernel(V x, B & bad){
+  bad = ~(B)(abs<V, B>(x) <= TRIG_MAX);
+  x = select(bad, splat<V>(0), x);
+
+  B n;
+  V y;
+  V r = reduce_pio2<Strict, V, B>(x, n, y);
+  B odd = (B)((n & 1) == 1);
+  if(Strict) return tan_poly<V, B>(r, y, odd);
+
+  V s = sin_poly(r, y);
+  V c = cos_poly(r, y);
+  return select(odd, -c, s) / select(odd, s, c);
+}
+
+template <UnaryOp Op, bool Strict, typename V, typename B>
+ALWAYS_INLINE V unary_kernel(V x, B & bad){
+  switch(Op){
+  case SinOp: return sin_kernel<Strict, 0, V, B>(x, bad);
+  case CosOp: return sin_kernel<Strict, 1, V, B>(x, bad);
+  case TanOp: return tan_kernel<Strict, V, B>(x, bad);
+  case ExpOp: return exp_kernel<Strict, V, B>(x, bad);
+  default: return log_kernel<Strict, V, B>(x, bad);
+  }
+}
+
+// load count <= width elements from p, padding with ones
+template <typename V>
+ALWAYS_INLINE V load(const double * p, std::size_t count){
+  V x;
+  if(count == sizeof(V) / sizeof(double)){
+    std::memcpy(&x, p, sizeof x);
+  }
+  else{
+    x = splat<V>(1);
+    std::memcpy(&x, p, count * sizeof(double));
+  }
+  return x;
+}
+
+// store count <= width elements to p
+template <typename V>
+ALWAYS_INLINE void store(double * p, V y, std::size_t count){
+  if(count == sizeof(V) / sizeof(double)){
+    std::memcpy(p, &y, sizeof y);
+  }
+  else{
+    std::memcpy(p, &y, count * sizeof(double));
+  }
+}
+
+template <typename B>
+ALWAYS_INLINE bool any(B mask){
+  std::uint64_t bits = 0;
+  for(std::size_t j = 0; j < sizeof(B) / sizeof(bits); ++j){
+    bits |= mask[j];
+  }
+  return bits != 0;
+}
+
+template <UnaryOp Op, bool Strict, typename V, typename B>
+ALWAYS_INLINE void unary_vector(const double * a, double * out, std::size_t n){
+  const std::size_t width = sizeof(V) / sizeof(double);
+  for(std::size_t i = 0; i < n; i += width){
+    std::size_t count = n - i < width ? n - i : width;
+    V x = load<V>(a + i, count);
+    B bad;
+    V y = unary_kernel<Op, Strict, V, B>(x, bad);
+    store(out + i, y, count);
+    if(!any(bad)) continue;
+    for(std::size_t j = 0; j < count; ++j){
+      if(bad[j]) out[i + j] = unary_std<Op>(x[j]);
+    }
+  }
+}
+
+template <bool Strict, typename V, typename B>
+ALWAYS_INLINE void unary_dispatch(UnaryOp op, const double * a, double * out, std::size_t n){
+  switch(op){
+  case SinOp: unary_vector<SinOp, Strict, V, B>(a, out, n); break;
+  case CosOp: unary_vector<CosOp, Strict, V, B>(a, out, n); break;
+  case TanOp: unary_vector<TanOp, Strict, V, B>(a, out, n); break;
+  case ExpOp: unary_vector<ExpOp, Strict, V, B>(a, out, n); break;
+  case LogOp: unary_vector<LogOp, Strict, V, B>(a, out, n); break;
+  case SqrtOp: break;
+  }
+}
+
+TARGET("sse2") static void unary_sse2(UnaryOp op, bool strict, const double * a, double * out, std::size_t n){
+  if(strict) unary_dispatch<true, Vec2, Bits2>(op, a, out, n);
+  else unary_dispatch<false, Vec2, Bits2>(op, a, out, n);
+}
+
+TARGET("avx2,fma") static void unary_avx2(UnaryOp op, bool strict, const double * a, double * out, std::size_t n){
+  if(strict) unary_dispatch<true, Vec4, Bits4>(op, a, out, n);
+  else unary_dispatch<false, Vec4, Bits4>(op, a, out, n);
+}
+
+// a^b = e^(b ln a) for positive a, which is accurate to about 1e-13 only
+// so used in fast mode alone
+template <typename V, typename B>
+ALWAYS_INLINE void power_vector(const double * a, bool a_scalar, const double * b, bool b_scalar,
+				double * out, std::size_t n){
+  const std::size_t width = sizeof(V) / sizeof(double);
+  for(std::size_t i = 0; i < n; i += width){
+    std::size_t count = n - i < width ? n - i : width;
+    V x = a_scalar ? splat<V>(*a) : load<V>(a + i, count);
+    V y = b_scalar ? splat<V>(*b) : load<V>(b + i, count);
+    B bad_log, bad_exp;
+    V l = log_kernel<false, V, B>(x, bad_log);
+    V p = exp_kernel<false, V, B>(y * l, bad_exp);
+    store(out + i, p, count);
+    B bad = bad_log | bad_exp;
+    if(!any(bad)) continue;
+    for(std::size_t j = 0; j < count; ++j){
+      if(bad[j]) out[i + j] = std::pow(x[j], y[j]);
+    }
+  }
+}
+
+TARGET("sse2") static void power_sse2(const double * a, bool a_scalar, const double * b, bool b_scalar,
+				      double * out, std::size_t n){
+  power_vector<Vec2, Bits2>(a, a_scalar, b, b_scalar, out, n);
+}
+
+TARGET("avx2,fma") static void power_avx2(const double * a, bool a_scalar, const double * b, bool b_scalar,
+					  double * out, std::size_t n){
+  power_vector<Vec4, Bits4>(a, a_scalar, b, b_scalar, out, n);
+}
+
+#endif
+
+template <BinaryOp Op>
+static void binary(const double * a, bool a_scalar, const double * b, bool b_scalar,
+		   double * out, std::size_t n){
+#ifdef SIMD_X86
+  switch(simd_level()){
+  case SimdAVX2:
+    binary_avx2<Op>(a, a_scalar, b, b_scalar, out, n);
+    return;
+  case SimdSSE2:
+    binary_sse2<Op>(a, a_scalar, b, b_scalar, out, n);
+    return;
+  case SimdScalar:
+    break;
+  }
+#endif
+  binary_scalar<Op>(a, a_scalar, b, b_scalar, out, n);
+}
+
+void simd_binary(BinaryOp op, const double * a, bool a_scalar,
+		 const double * b, bool b_scalar, double * out, std::size_t n) noexcept{
+
+  if(n == 0) return;
+
+  switch(op){
+  case AddOp: binary<AddOp>(a, a_scalar, b, b_scalar, out, n); break;
+  case SubOp: binary<SubOp>(a, a_scalar, b, b_scalar, out, n); break;
+  case MulOp: binary<MulOp>(a, a_scalar, b, b_scalar, out, n); break;
+  case DivOp: binary<DivOp>(a, a_scalar, b, b_scalar, out, n); break;
+  case PowOp:
+#ifdef SIMD_X86
+    if(math_accuracy() == FastMath && simd_level() == SimdAVX2){
+      power_avx2(a, a_scalar, b, b_scalar, out, n);
+      return;
+    }
+    if(math_accuracy() == FastMath && simd_level() == SimdSSE2){
+      power_sse2(a, a_scalar, b, b_scalar, out, n);
+      return;
+    }
+#endif
+    binary_scalar<PowOp>(a, a_scalar, b, b_scalar, out, n);
+    break;
+  }
+}
+
+void simd_unary(UnaryOp op, const double * a, double * out, std::size_t n) noexcept{
+
+#ifdef SIMD_X86
+  bool strict = math_accuracy() == StrictMath;
+  switch(simd_level()){
+  case SimdAVX2:
+    if(op == SqrtOp) sqrt_avx2(a, out, n);
+    else unary_avx2(op, strict, a, out, n);
+    return;
+  case SimdSSE2:
+    if(op == SqrtOp) sqrt_sse2(a, out, n);
+    else unary_sse2(op, strict, a, out, n);
+    return;
+  case SimdScalar:
+    break;
+  }
+#endif
+  switch(op){
+  case SqrtOp: unary_scalar<SqrtOp>(a, out, n); break;
+  case SinOp: unary_scalar<SinOp>(a, out, n); break;
+  case CosOp: unary_scalar<CosOp>(a, out, n); break;
+  case TanOp: unary_scalar<TanOp>(a, out, n); break;
+  case ExpOp: unary_scalar<ExpOp>(a, out, n); break;
+  case LogOp: unary_scalar<LogOp>(a, out, n); break;
+  }
+}
+
@@ -0,0 +1,83 @@
+/*! \file simd.hpp
+Defines elementwise kernels over arrays of doubles, used by the numeric
+builtins when their arguments are packed lists.
+
+The kernels have scalar, SSE2 and AVX2 versions, and the widest one the
+processor supports is selected at runtime. The arithmetic versions round
+every element exactly as the scalar operator would, so their result does
+not depend on the selection. The vector versions of the transcendental
+functions are polynomial approximations with two accuracy tiers, see
+MathAccuracy; the scalar versions call std::.
+ */
+#ifndef SIMD_HPP
+#define SIMD_HPP
+
+// system includes
+#include <cstddef>
+
+/*! \enum SimdLevel
+  \brief An instruction set the kernels can use, from narrowest to widest.
+ */
+enum SimdLevel { SimdScalar,  ///< one element at a time
+		 SimdSSE2,    ///< two elements at a time
+		 SimdAVX2     ///< four elements at a time
+};
+
+/// the widest instruction set the processor supports
+SimdLevel simd_supported() noexcept;
+
+/// the instruction set the kernels use, by default simd_supported()
+SimdLevel simd_level() noexcept;
+
+/*! Select the instruction set the kernels use, e.g. to compare them.
+  \param level the level wanted, lowered to simd_supported() if wider
+ */
+void set_simd_level(SimdLevel level) noexcept;
+
+/*! \enum MathAccuracy
+  \brief How closely the vector transcendental functions follow std::.
+
+  Strict mode computes PowOp with std::pow. Fast mode computes it as
+  e^(b ln a) for positive a.
+ */
+enum MathAccuracy { StrictMath, ///< within 1 ulp of std::, the default
+		    FastMath    ///< within 1e-12 relative error, e.g. for plotting
+};
+
+/// the accuracy of the transcendental functions
+MathAccuracy math_accuracy() noexcept;
+
+/// select the accuracy of the transcendental functions
+void set_math_accuracy(MathAccuracy mode) noexcept;
+
+/*! \enum BinaryOp
+  \brief An elementwise operator of two operands.
+ */
+enum BinaryOp { AddOp, SubOp, MulOp, DivOp, PowOp };
+
+/*! \enum UnaryOp
+  \brief An elementwise function of one operand.
+ */
+enum UnaryOp { SqrtOp, SinOp, CosOp, TanOp, ExpOp, LogOp };
+
+/*! Apply a binary operator elementwise, out[i] = a[i] op b[i].
+  \param op the operator
+  \param a the left operands, or with a_scalar the one broadcast to every element
+  \param a_scalar true to broadcast a[0]
+  \param b the right operands, or with b_scalar the one broadcast to every element
+  \param b_scalar true to broadcast b[0]
+  \param out the results, which may be a or b
+  \param n the number of elements
+ */
+void simd_binary(BinaryOp op, const double * a, bool a_scalar,
+		 const double * b, bool b_scalar, double * out, std::size_t n) noexcept;
+
+/*! Apply a function elementwise, out[i] = op(a[i]).
+  \param op the function
+  \param a the operands
+  \param out the results, which may be a
+  \param n the number of elements
+ */
+void simd_unary(UnaryOp op, const double * a, double * out, std::size_t n) noexcept;
+
+#endif
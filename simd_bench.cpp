@@ -0,0 +1,96 @@
+// Compares the throughput of the simd kernels with scalar std:: calls over
+// 10^7 samples, for each instruction set and accuracy.
+//
+// usage: simd_bench [samples]
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include "simd.hpp"
+
+static const char * level_name(SimdLevel level){
+  switch(level){
+  case SimdScalar: return "scalar";
+  case SimdSSE2: return "sse2";
+  case SimdAVX2: return "avx2";
+  }
+  return "";
+}
+
+// the best of a few runs in millions of samples per second
+template <typename F>
+static double throughput(std::size_t n, F run){
+
+  double best = 0;
+  for(int i = 0; i < 3; ++i){
+    auto start = std::chrono::steady_clock::now();
+    run();
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    double rate = n / elapsed.count() / 1e6;
+    if(rate > best) best = rate;
+  }
+  return best;
+}
+
+int main(int argc, char * argv[]){
+
+  std::size_t n = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000000;
+
+  // the sample points of a plot over [-10, 10], and positive ones for ln
+  std::vector<double> x(n), positive(n), out(n);
+  for(std::size_t i = 0; i < n; ++i){
+    x[i] = -10 + 20.0 * i / n;
+    positive[i] = 1e-3 + 100.0 * i / n;
+  }
+
+  struct Case { const char * name; UnaryOp op; double (*f)(double); const std::vector<double> * x; };
+  const Case cases[] = {
+    {"sqrt", SqrtOp, std::sqrt, &positive},
+    {"sin", SinOp, std::sin, &x},
+    {"cos", CosOp, std::cos, &x},
+    {"tan", TanOp, std::tan, &x},
+    {"exp", ExpOp, std::exp, &x},
+    {"ln", LogOp, std::log, &positive},
+  };
+
+  std::printf("%zu samples, Msamples/s\n", n);
+  std::printf("%-6s %10s", "", "libm");
+  for(int level = SimdSSE2; level <= simd_supported(); ++level){
+    std::printf(" %8s-strict %8s-fast", level_name(SimdLevel(level)), level_name(SimdLevel(level)));
+  }
+  std::printf("\n");
+
+
+  for(const Case & c : cases){
+    const double * in = c.x->data();
+    std::printf("%-6s %10.1f", c.name, throughput(n, [&](){
+	  for(std::size_t i = 0; i < n; ++i) out[i] = c.f(in[i]);
+	}));
+    for(int level = SimdSSE2; level <= simd_supported(); ++level){
+      set_simd_level(SimdLevel(level));
+      for(MathAccuracy mode : {StrictMath, FastMath}){
+	set_math_accuracy(mode);
+	std::printf(" %15.1f", throughput(n, [&](){ simd_unary(c.op, in, out.data(), n); }));
+      }
+    }
+    std::printf("\n");
+  }
+
+  const double base = 1.5;
+  std::printf("%-6s %10.1f", "^", throughput(n, [&](){
+	for(std::size_t i = 0; i < n; ++i) out[i] = std::pow(base, x[i]);
+      }));
+  for(int level = SimdSSE2; level <= simd_supported(); ++level){
+    set_simd_level(SimdLevel(level));
+    for(MathAccuracy mode : {StrictMath, FastMath}){
+      set_math_accuracy(mode);
+      std::printf(" %15.1f", throughput(n, [&](){ simd_binary(PowOp, &base, true, x.data(), false, out.data(), n); }));
+    }
+  }
+  std::printf("\n");
+
+  return EXIT_SUCCESS;
+}
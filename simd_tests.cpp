@@ -0,0 +1,229 @@
+#include "catch.hpp"
+
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "simd.hpp"
+
+// restores the simd level and math accuracy selected before the test
+struct LevelGuard {
+  SimdLevel saved = simd_level();
+  MathAccuracy accuracy = math_accuracy();
+  ~LevelGuard() { set_simd_level(saved); set_math_accuracy(accuracy); }
+};
+
+// elementwise equality, taking NaN to equal NaN
+static bool same(const std::vector<double> & a, const std::vector<double> & b){
+
+  if(a.size() != b.size()) return false;
+  for(std::size_t i = 0; i < a.size(); ++i){
+    if(a[i] != b[i] && !(std::isnan(a[i]) && std::isnan(b[i]))) return false;
+  }
+  return true;
+}
+
+static std::vector<double> operands(std::size_t n, double offset){
+
+  std::vector<double> values(n);
+  for(std::size_t i = 0; i < n; ++i){
+    values[i] = offset + 0.37 * static_cast<double>(i) - 3.1;
+  }
+  return values;
+}
+
+TEST_CASE( "Test selecting the simd level", "[simd]" ) {
+
+  LevelGuard guard;
+
+  set_simd_level(SimdScalar);
+  REQUIRE(simd_level() == SimdScalar);
+
+  set_simd_level(SimdAVX2);
+  REQUIRE(simd_level() == simd_supported());
+}
+
+TEST_CASE( "Test binary kernels", "[simd]" ) {
+
+  LevelGuard guard;
+
+  // every length up to past two vectors, to cover the remainder loops
+  for(std::size_t n = 0; n < 11; ++n){
+    std::vector<double> a = operands(n, 0), b = operands(n, 5);
+
+    for(BinaryOp op : {AddOp, SubOp, MulOp, DivOp, PowOp}){
+      std::vector<double> expected(n), scalar_a(n), scalar_b(n);
+      for(std::size_t i = 0; i < n; ++i){
+	switch(op){
+	case AddOp: expected[i] = a[i] + b[i]; scalar_a[i] = 2 + b[i]; scalar_b[i] = a[i] + 2; break;
+	case SubOp: expected[i] = a[i] - b[i]; scalar_a[i] = 2 - b[i]; scalar_b[i] = a[i] - 2; break;
+	case MulOp: expected[i] = a[i] * b[i]; scalar_a[i] = 2 * b[i]; scalar_b[i] = a[i] * 2; break;
+	case DivOp: expected[i] = a[i] / b[i]; scalar_a[i] = 2 / b[i]; scalar_b[i] = a[i] / 2; break;
+	case PowOp: expected[i] = std::pow(a[i], b[i]); scalar_a[i] = std::pow(2, b[i]); scalar_b[i] = std::pow(a[i], 2); break;
+	}
+      }
+
+      for(SimdLevel level : {SimdScalar, SimdSSE2, SimdAVX2}){
+	set_simd_level(level);
+	INFO("op " << op << ", level " << simd_level() << ", length " << n);
+
+	std::vector<double> out(n);
+	const double two = 2;
+	simd_binary(op, a.data(), false, b.data(), false, out.data(), n);
+	REQUIRE(same(out, expected));
+	simd_binary(op, &two, true, b.data(), false, out.data(), n);
+	REQUIRE(same(out, scalar_a));
+	simd_binary(op, a.data(), false, &two, true, out.data(), n);
+	REQUIRE(same(out, scalar_b));
+
+	out = a;
+	simd_binary(op, out.data(), false, b.data(), false, out.data(), n);
+	REQUIRE(same(out, expected));
+      }
+    }
+  }
+}
+
+TEST_CASE( "Test the square root kernel", "[simd]" ) {
+
+  LevelGuard guard;
+
+  for(std::size_t n = 0; n < 11; ++n){
+    std::vector<double> a = operands(n, 4);
+
+    for(SimdLevel level : {SimdScalar, SimdSSE2, SimdAVX2}){
+      set_simd_level(level);
+      INFO("level " << simd_level() << ", length " << n);
+
+      std::vector<double> out(n);
+      simd_unary(SqrtOp, a.data(), out.data(), n);
+      for(std::size_t i = 0; i < n; ++i){
+	REQUIRE(out[i] == std::sqrt(a[i]));
+      }
+    }
+  }
+}
+
+// the distance between a and b in units in the last place
+static std::uint64_t ulps(double a, double b){
+
+  if(std::isnan(a) || std::isnan(b)) return std::isnan(a) && std::isnan(b) ? 0 : UINT64_MAX;
+
+  std::int64_t i, j;
+  std::memcpy(&i, &a, sizeof i);
+  std::memcpy(&j, &b, sizeof j);
+  if(i < 0) i = INT64_MIN - i;
+  if(j < 0) j = INT64_MIN - j;
+  return i > j ? std::uint64_t(i) - std::uint64_t(j) : std::uint64_t(j) - std::uint64_t(i);
+}
+
+// true if a is within relative error 1e-12 of b, or the same special value
+static bool close(double a, double b){
+
+  if(std::isfinite(b) && b != 0) return std::fabs(a - b) <= 1e-12 * std::fabs(b);
+  return ulps(a, b) == 0;
+}
+
+// the first index where out is not accurate to expected, or out.size()
+template <typename P>
+static std::size_t first_inaccurate(const std::vector<double> & out, const std::vector<double> & expected, P accurate){
+
+  for(std::size_t i = 0; i < out.size(); ++i){
+    if(!accurate(out[i], expected[i])) return i;
+  }
+  return out.size();
+}
+
+// arguments spread over the domain the kernels reduce, near the multiples
+// of pi/2, and the special values they leave to std::
+static std::vector<double> arguments(double low, double high){
+
+  std::vector<double> values;
+  const int n = 20000;
+  for(int i = 0; i <= n; ++i){
+    values.push_back(low + (high - low) * i / n);
+    values.push_back(std::ldexp(1.0 + double(i) / n, i % 80 - 60));
+    values.push_back(-std::ldexp(1.0 + double(i) / n, i % 80 - 60));
+  }
+  for(int k = -2000; k <= 2000; ++k){
+    double x = k * 1.5707963267948966;
+    values.push_back(x);
+    values.push_back(std::nextafter(x, 1e6));
+  }
+  const double special[] = {0.0, -0.0, 1e-310, 700, -700, 710, -750, 1e6, -1e6, 1e300,
+			    std::numeric_limits<double>::infinity(),
+			    -std::numeric_limits<double>::infinity(),
+			    std::numeric_limits<double>::quiet_NaN()};
+  values.insert(values.end(), std::begin(special), std::end(special));
+  return values;
+}
+
+TEST_CASE( "Test the transcendental kernels", "[simd]" ) {
+
+  LevelGuard guard;
+
+  struct Function { UnaryOp op; double (*f)(double); double low, high; };
+  const Function functions[] = {
+    {SinOp, std::sin, -1e5, 1e5},
+    {CosOp, std::cos, -1e5, 1e5},
+    {TanOp, std::tan, -1e5, 1e5},
+    {ExpOp, std::exp, -745, 710},
+    {LogOp, std::log, 0, 1e300},
+  };
+
+  for(const Function & function : functions){
+    std::vector<double> x = arguments(function.low, function.high);
+    std::vector<double> expected(x.size()), out(x.size());
+    for(std::size_t i = 0; i < x.size(); ++i){
+      expected[i] = function.f(x[i]);
+    }
+
+    for(SimdLevel level : {SimdScalar, SimdSSE2, SimdAVX2}){
+      set_simd_level(level);
+
+      set_math_accuracy(StrictMath);
+      simd_unary(function.op, x.data(), out.data(), x.size());
+      std::size_t i = first_inaccurate(out, expected, [](double a, double b) { return ulps(a, b) <= 1; });
+      INFO("strict op " << function.op << ", level " << simd_level() << ", x " << (i < x.size() ? x[i] : 0));
+      REQUIRE(i == x.size());
+
+      set_math_accuracy(FastMath);
+      simd_unary(function.op, x.data(), out.data(), x.size());
+      i = first_inaccurate(out, expected, close);
+      INFO("fast op " << function.op << ", level " << simd_level() << ", x " << (i < x.size() ? x[i] : 0));
+      REQUIRE(i == x.size());
+    }
+  }
+}
+
+TEST_CASE( "Test the power kernel", "[simd]" ) {
+
+  LevelGuard guard;
+
+  std::vector<double> base = arguments(-10, 10), exponent(base.size());
+  std::vector<double> expected(base.size()), out(base.size());
+  for(std::size_t i = 0; i < base.size(); ++i){
+    exponent[i] = std::fmod(base[i] * 7.3, 40);
+    expected[i] = std::pow(base[i], exponent[i]);
+  }
+
+  for(SimdLevel level : {SimdScalar, SimdSSE2, SimdAVX2}){
+    set_simd_level(level);
+
+    set_math_accuracy(StrictMath);
+    simd_binary(PowOp, base.data(), false, exponent.data(), false, out.data(), out.size());
+    REQUIRE(first_inaccurate(out, expected, [](double a, double b) { return ulps(a, b) == 0; }) == out.size());
+
+    set_math_accuracy(FastMath);
+    simd_binary(PowOp, base.data(), false, exponent.data(), false, out.data(), out.size());
+    std::size_t i = first_inaccurate(out, expected, close);
+    INFO("level " << simd_level() << ", " << (i < out.size() ? base[i] : 0) << " ^ " << (i < out.size() ? exponent[i] : 0));
+    REQUIRE(i == out.size());
+
+    const double two = 2;
+    simd_binary(PowOp, &two, true, exponent.data(), false, out.data(), out.size());
+    REQUIRE(close(out[7], std::pow(2, exponent[7])));
+  }
+}
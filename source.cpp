@@ -0,0 +1,118 @@
+#include "source.hpp"
+
+// system includes
+#include <fstream>
+#include <iterator>
+#include <utility>
+
+#if defined(__APPLE__) || defined(__linux) || defined(__unix) || defined(__posix)
+#define SOURCE_MMAP
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+SourceBuffer::SourceBuffer() noexcept: m_map(nullptr), m_map_size(0){}
+
+SourceBuffer::SourceBuffer(const std::string & text): m_map(nullptr), m_map_size(0), m_text(text){}
+
+SourceBuffer::~SourceBuffer(){
+
+  clear();
+}
+
+SourceBuffer::SourceBuffer(SourceBuffer && other) noexcept:
+  m_map(other.m_map), m_map_size(other.m_map_size), m_text(std::move(other.m_text)){
+
+  other.m_map = nullptr;
+  other.m_map_size = 0;
+}
+
+SourceBuffer & SourceBuffer::operator=(SourceBuffer && other) noexcept{
+
+  if(this != &other){
+    clear();
+    m_map = other.m_map;
+    m_map_size = other.m_map_size;
+    m_text = std::move(other.m_text);
+    other.m_map = nullptr;
+    other.m_map_size = 0;
+  }
+  return *this;
+}
+
+void SourceBuffer::clear() noexcept{
+
+#ifdef SOURCE_MMAP
+  if(m_map != nullptr){
+    munmap(const_cast<char *>(m_map), m_map_size);
+  }
+#endif
+  m_map = nullptr;
+  m_map_size = 0;
+  m_text.clear();
+}
+
+bool SourceBuffer::open(const std::string & filename) noexcept{
+
+  clear();
+
+#ifdef SOURCE_MMAP
+  int fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0){
+    return false;
+  }
+
+  struct stat info;
+  if(fstat(fd, &info) == 0 && S_ISREG(info.st_mode) && info.st_size > 0){
+    void * map = mmap(nullptr, static_cast<std::size_t>(info.st_size),
+		      PROT_READ, MAP_PRIVATE, fd, 0);
+    if(map != MAP_FAILED){
+#ifdef MADV_SEQUENTIAL
+      madvise(map, static_cast<std::size_t>(info.st_size), MADV_SEQUENTIAL);
+#endif
+      ::close(fd);
+      m_map = static_cast<const char *>(map);
+      m_map_size = static_cast<std::size_t>(info.st_size);
+      return true;
+    }
+  }
+  ::close(fd);
+#endif
+
+  // empty files, pipes and platforms without mmap are read instead
+  try{
+    std::ifstream ifs(filename, std::ios::binary);
+    if(!ifs){
+      return false;
+    }
+    read(ifs);
+  }
+  catch(...){
+    clear();
+    return false;
+  }
+  return true;
+}
+
+void SourceBuffer::read(std::istream & stream){
+
+  clear();
+  m_text.assign(std::istreambuf_iterator<char>(stream), std::istreambuf_iterator<char>());
+}
+
+const char * SourceBuffer::data() const noexcept{
+
+  return (m_map != nullptr) ? m_map : m_text.data();
+}
+
+std::size_t SourceBuffer::size() const noexcept{
+
+  return (m_map != nullptr) ? m_map_size : m_text.size();
+}
+
+bool SourceBuffer::mapped() const noexcept{
+
+  return m_map != nullptr;
+}
@@ -0,0 +1,75 @@
+/*! \file source.hpp
+Defines the buffer holding the text of a program while it is tokenized.
+ */
+#ifndef SOURCE_HPP
+#define SOURCE_HPP
+
+// system includes
+#include <cstddef>
+#include <istream>
+#include <string>
+
+/*! \class SourceBuffer
+\brief The characters of a program in one contiguous block of memory.
+
+A file is memory-mapped where the platform supports it, so loading it costs
+no more than the page faults of reading it once. Streams and strings are
+copied into a buffer owned by the SourceBuffer. Either way the characters
+stay in place until the SourceBuffer is destroyed or reloaded, so tokens
+may refer to them by offset, see TokenView.
+ */
+class SourceBuffer {
+public:
+
+  /// Construct an empty buffer
+  SourceBuffer() noexcept;
+
+  /// Construct a buffer holding a copy of text
+  explicit SourceBuffer(const std::string & text);
+
+  /// unmap or free the characters
+  ~SourceBuffer();
+
+  /// moving keeps the characters in place
+  SourceBuffer(SourceBuffer && other) noexcept;
+
+  /// moving keeps the characters in place
+  SourceBuffer & operator=(SourceBuffer && other) noexcept;
+
+  SourceBuffer(const SourceBuffer &) = delete;
+  SourceBuffer & operator=(const SourceBuffer &) = delete;
+
+  /*! Load a file, replacing the current contents
+    \param filename the file to map or read
+    \return false if the file could not be opened, leaving the buffer empty
+   */
+  bool open(const std::string & filename) noexcept;
+
+  /*! Load the rest of a stream, replacing the current contents
+    \param stream the stream to read until end of file
+   */
+  void read(std::istream & stream);
+
+  /// the first character
+  const char * data() const noexcept;
+
+  /// the number of characters
+  std::size_t size() const noexcept;
+
+  /// true if the characters are a mapping of a file
+  bool mapped() const noexcept;
+
+private:
+
+  // unmap the file, if any, and empty the buffer
+  void clear() noexcept;
+
+  // the mapped file, if any
+  const char * m_map;
+  std::size_t m_map_size;
+
+  // the characters when not mapped
+  std::string m_text;
+};
+
+#endif
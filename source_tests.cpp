@@ -0,0 +1,56 @@
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "source.hpp"
+
+// write text to a scratch file, returning its name
+static std::string scratch_file(const std::string & text){
+
+  std::string name = "source_tests_scratch.pls";
+  std::ofstream ofs(name, std::ios::binary);
+  ofs << text;
+  return name;
+}
+
+TEST_CASE( "Test SourceBuffer from a string", "[source]" ) {
+
+  SourceBuffer empty;
+  REQUIRE(empty.size() == 0);
+  REQUIRE(!empty.mapped());
+
+  SourceBuffer source("(+ 1 2)");
+  REQUIRE(std::string(source.data(), source.size()) == "(+ 1 2)");
+  REQUIRE(!source.mapped());
+
+  std::istringstream iss("(list a b)");
+  source.read(iss);
+  REQUIRE(std::string(source.data(), source.size()) == "(list a b)");
+}
+
+TEST_CASE( "Test SourceBuffer from a file", "[source]" ) {
+
+  std::string text = "(begin\n  (define a 1) ; comment\n  (+ a 2))\n";
+  std::string name = scratch_file(text);
+
+  SourceBuffer source;
+  REQUIRE(source.open(name));
+  REQUIRE(std::string(source.data(), source.size()) == text);
+
+  // the characters stay in place when moved
+  const char * data = source.data();
+  SourceBuffer moved(std::move(source));
+  REQUIRE(moved.data() == data);
+  REQUIRE(moved.size() == text.size());
+  REQUIRE(source.size() == 0);
+
+  scratch_file("");
+  REQUIRE(moved.open(name));
+  REQUIRE(moved.size() == 0);
+
+  std::remove(name.c_str());
+  REQUIRE(!moved.open(name));
+  REQUIRE(moved.size() == 0);
+}
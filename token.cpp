@@ -2,7 +2,8 @@
 
 // system includes
 #include <cctype>
-#include <iostream>
+#include <cstring>
+#include <iterator>
 
 // define constants for special characters
 const char OPENCHAR = '(';
@@ -32,78 +33,113 @@ std::string Token::asString() const{
 }
 
 
-// add token to sequence unless it is empty, clears token
-void store_ifnot_empty(std::string & token, TokenSequenceType & seq){
-  if(!token.empty()){
-    seq.emplace_back(token);
-    token.clear();
+Token TokenView::asToken(const char * data) const{
+
+  if(type != Token::STRING){
+    return Token(type);
   }
+  return Token(std::string(data + offset, length));
 }
 
 TokenSequenceType tokenize(std::istream & seq){
+
+  std::string text((std::istreambuf_iterator<char>(seq)), std::istreambuf_iterator<char>());
+
   TokenSequenceType tokens;
-  std::string token;
-  //bool isString = false;
-  
-  while(true){
-    char c = seq.get();
-    if(seq.eof()) break;
-    
-    if(c == COMMENTCHAR){
-      // chomp until the end of the line
-      while((!seq.eof()) && (c != '\n')){
-	c = seq.get();
-      }
-      if(seq.eof()) break;
-    }
-    else if(c == OPENCHAR){
-      store_ifnot_empty(token, tokens);
-      tokens.push_back(Token::TokenType::OPEN);
+  for(auto & view : tokenize(text.data(), text.size())){
+    tokens.push_back(view.asToken(text.data()));
+  }
+  return tokens;
+}
+
+// the role of each character in splitting a buffer
+enum CharClass : unsigned char { TokenChar, SpaceChar, OpenChar, CloseChar,
+				 CommentChar, StringChar };
+
+// the class of every character, looked up once per character
+struct CharClasses {
+  CharClass of[256];
+
+  CharClasses(){
+    for(int c = 0; c < 256; ++c){
+      of[c] = std::isspace(c) ? SpaceChar : TokenChar;
     }
-    else if(c == CLOSECHAR){
-      store_ifnot_empty(token, tokens);
-      tokens.push_back(Token::TokenType::CLOSE);
+    of[static_cast<unsigned char>(OPENCHAR)] = OpenChar;
+    of[static_cast<unsigned char>(CLOSECHAR)] = CloseChar;
+    of[static_cast<unsigned char>(COMMENTCHAR)] = CommentChar;
+    of[static_cast<unsigned char>(OPENSTRINGCHAR)] = StringChar;
+  }
+
+  CharClass operator()(char c) const{
+    return of[static_cast<unsigned char>(c)];
+  }
+};
+
+bool next_token(const char * data, std::size_t size, std::size_t & position,
+		TokenView & token) noexcept{
+
+  static const CharClasses classify;
+
+  std::size_t i = position;
+  while(i < size){
+    switch(classify(data[i])){
+    case SpaceChar:
+      i += 1;
+      break;
+    case OpenChar:
+      token = TokenView{Token::OPEN, i, 1};
+      position = i + 1;
+      return true;
+    case CloseChar:
+      token = TokenView{Token::CLOSE, i, 1};
+      position = i + 1;
+      return true;
+    case CommentChar:{
+      // chomp until the end of the line
+      const void * eol = std::memchr(data + i, '\n', size - i);
+      i = (eol == nullptr) ? size : static_cast<const char *>(eol) - data + 1;
+      break;
     }
-	/*else if (c == OPENSTRINGCHAR && !isString)
-	{
-		store_ifnot_empty(token, tokens);
-		token.push_back(c);
-		isString = true;
-	}*/
-	else if (c == OPENSTRINGCHAR)
-	{
-		//store_ifnot_empty(token, tokens);
-		token.push_back(c);
-		bool stringIsOver = false;
-		while (!stringIsOver)
-		{
-			char c = seq.get();
-
-			if (c != CLOSESTRINGCHAR) 
-			{
-				token.push_back(c);
-			}
-			else
-			{
-				token.push_back(c);
-				stringIsOver = true;
-			}
-		}
+    default:{
+      // a string token runs to the next space, paren or comment, and any
+      // string in it, quotes included, is part of it
+      std::size_t start = i;
+      while(i < size){
+	CharClass k = classify(data[i]);
+	if(k == TokenChar){
+	  i += 1;
+	}
+	else if(k == StringChar){
+	  const void * close = std::memchr(data + i + 1, CLOSESTRINGCHAR, size - i - 1);
+	  i = (close == nullptr) ? size : static_cast<const char *>(close) - data + 1;
+	}
+	else{
+	  break;
 	}
-	/*else if (c == CLOSESTRINGCHAR && isString)
-	{
-		store_ifnot_empty(token, tokens);
-		token.push_back(c);
-		isString = false;
-	}*/
-    else if(isspace(c)){
-      store_ifnot_empty(token, tokens);
+      }
+      token = TokenView{Token::STRING, start, i - start};
+      position = i;
+      return true;
     }
-    else{
-      token.push_back(c);
     }
   }
-  store_ifnot_empty(token, tokens);
+
+  position = size;
+  return false;
+}
+
+TokenViewSequenceType tokenize(const char * data, std::size_t size){
+
+  // most programs have a token every few characters, reserving for that
+  // avoids copying the sequence as it grows
+  TokenViewSequenceType tokens;
+  tokens.reserve(size / 4);
+
+  std::size_t position = 0;
+  TokenView token;
+  while(next_token(data, size, position, token)){
+    tokens.push_back(token);
+  }
 
   return tokens;
 }
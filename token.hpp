@@ -4,8 +4,11 @@ Defines the Token and TokenSequence types, and associated functions.
 #ifndef TOKEN_HPP
 #define TOKEN_HPP
 
+#include <cstddef>
 #include <deque>
 #include <istream>
+#include <string>
+#include <vector>
 
 /*! \class Token
   \brief Value class representing a token.
@@ -59,4 +62,54 @@ Ignores any whitespace and comments (from any ";" to end-of-line).
 */
 TokenSequenceType tokenize(std::istream & seq);
 
+/*! \class TokenView
+  \brief A token as the range of characters it spans in a buffer.
+
+  Unlike Token it owns no string, so tokenizing a buffer allocates nothing
+  but the sequence itself. The buffer must outlive the views into it.
+*/
+struct TokenView {
+
+  /// the type of the token
+  Token::TokenType type;
+
+  /// the position of the first character in the buffer
+  std::size_t offset;
+
+  /// the number of characters, 1 for OPEN and CLOSE
+  std::size_t length;
+
+  /// return the token as an owning Token
+  Token asToken(const char * data) const;
+};
+
+/*! \typedef TokenViewSequenceType
+Define the sequence of token views, stored contiguously.
+ */
+typedef std::vector<TokenView> TokenViewSequenceType;
+
+/*! \fn bool next_token(const char * data, std::size_t size, std::size_t & position, TokenView & token)
+\brief Scan the next token of a buffer, for readers that need no sequence
+
+\param data the first character of the buffer
+\param size the number of characters in the buffer
+\param position where to start, advanced past the token
+\param token set to the token found
+\return false if only whitespace and comments remain
+*/
+bool next_token(const char * data, std::size_t size, std::size_t & position,
+		TokenView & token) noexcept;
+
+/*! \fn TokenViewSequenceType tokenize(const char * data, std::size_t size)
+\brief Split a buffer into a sequence of token views
+
+\param data the first character of the buffer
+\param size the number of characters in the buffer
+\return The sequence of views into the buffer
+
+Splits by the same rules as tokenize(std::istream &), calling next_token
+until the end. A string left unterminated runs to the end of the buffer.
+*/
+TokenViewSequenceType tokenize(const char * data, std::size_t size);
+
 #endif
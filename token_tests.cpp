@@ -73,3 +73,38 @@ TEST_CASE( "Test tokenize", "[token]" ) {
   REQUIRE(tokens.empty());
 }
 
+
+TEST_CASE( "Test tokenize into views of a buffer", "[token]" ) {
+  std::string input = "(define s \"a (b) ;c\")x;comment\n(+ 1 2) \"open";
+
+  TokenViewSequenceType tokens = tokenize(input.data(), input.size());
+
+  std::vector<std::string> expected = {"(", "define", "s", "\"a (b) ;c\"", ")",
+				       "x", "(", "+", "1", "2", ")", "\"open"};
+
+  REQUIRE(tokens.size() == expected.size());
+  for(std::size_t i = 0; i < tokens.size(); ++i){
+    REQUIRE(tokens[i].asToken(input.data()).asString() == expected[i]);
+  }
+
+  REQUIRE(tokens[1].type == Token::STRING);
+  REQUIRE(tokens[1].offset == 1);
+  REQUIRE(tokens[1].length == 6);
+  REQUIRE(tokens[4].type == Token::CLOSE);
+
+  REQUIRE(tokenize(input.data(), 0).empty());
+}
+
+TEST_CASE( "Test tokenize a stream and a buffer alike", "[token]" ) {
+  std::string input = "(begin (define a \"a b\") ; note\n\t(list a 1e3 -2))";
+
+  std::istringstream iss(input);
+  TokenSequenceType tokens = tokenize(iss);
+  TokenViewSequenceType views = tokenize(input.data(), input.size());
+
+  REQUIRE(tokens.size() == views.size());
+  for(std::size_t i = 0; i < views.size(); ++i){
+    REQUIRE(tokens[i].type() == views[i].type);
+    REQUIRE(tokens[i].asString() == views[i].asToken(input.data()).asString());
+  }
+}
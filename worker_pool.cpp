@@ -0,0 +1,143 @@
+#include "worker_pool.hpp"
+
+// system includes
+#include <atomic>
+#include <condition_variable>
+#include <exception>
+#include <limits>
+
+// set in every worker thread
+static thread_local bool is_worker = false;
+
+// the tasks of one call to run still to finish
+struct WorkerPool::Batch {
+  std::size_t remaining;
+  std::mutex mutex;
+  std::condition_variable done;
+};
+
+WorkerPool::WorkerPool(std::size_t workers){
+  reserve(workers);
+}
+
+WorkerPool::~WorkerPool(){
+
+  std::lock_guard<std::mutex> lock(threads_mutex);
+
+  for(std::size_t i = 0; i < threads.size(); ++i){
+    jobs.push(Job{nullptr, nullptr});
+  }
+  for(auto & t : threads){
+    t.join();
+  }
+}
+
+WorkerPool & WorkerPool::shared(){
+  static WorkerPool pool(0);
+  return pool;
+}
+
+bool WorkerPool::in_worker() noexcept{
+  return is_worker;
+}
+
+void WorkerPool::reserve(std::size_t workers){
+
+  std::lock_guard<std::mutex> lock(threads_mutex);
+
+  while(threads.size() < workers){
+    threads.emplace_back(&WorkerPool::work, this);
+  }
+}
+
+std::size_t WorkerPool::size() const{
+
+  std::lock_guard<std::mutex> lock(threads_mutex);
+  return threads.size();
+}
+
+void WorkerPool::execute(const Job & job){
+
+  (*job.task)();
+
+  std::lock_guard<std::mutex> lock(job.batch->mutex);
+  if(--job.batch->remaining == 0){
+    job.batch->done.notify_all();
+  }
+}
+
+void WorkerPool::work(){
+
+  is_worker = true;
+
+  while(true){
+    Job job;
+    jobs.wait_and_pop(job);
+    if(job.task == nullptr) return;
+    execute(job);
+  }
+}
+
+void WorkerPool::run(std::vector<std::function<void()> > & tasks){
+
+  Batch batch;
+  batch.remaining = tasks.size();
+
+  for(auto & task : tasks){
+    jobs.push(Job{&task, &batch});
+  }
+
+  // help with queued work rather than sit idle
+  Job job;
+  while(jobs.try_pop(job)){
+    if(job.task == nullptr){
+      // a stop request meant for a worker, hand it back
+      jobs.push(job);
+      break;
+    }
+    execute(job);
+  }
+
+  std::unique_lock<std::mutex> lock(batch.mutex);
+  batch.done.wait(lock, [&batch]{ return batch.remaining == 0; });
+}
+
+void parallel_for(std::size_t count, std::size_t chunks,
+                  const std::function<void(std::size_t)> & body){
+
+  if(chunks == 0) chunks = 1;
+
+  // lowest index that raised, and what it raised
+  const std::size_t none = std::numeric_limits<std::size_t>::max();
+  std::atomic<std::size_t> first_error(none);
+  std::mutex error_mutex;
+  std::exception_ptr error;
+
+  std::vector<std::function<void()> > tasks;
+  std::size_t size = (count + chunks - 1) / chunks;
+  for(std::size_t begin = 0; begin < count; begin += size){
+    std::size_t end = (begin + size < count) ? begin + size : count;
+    tasks.push_back([&, begin, end]{
+      // indices past an error already found will not be used
+      for(std::size_t i = begin; (i < end) && (i < first_error); ++i){
+        try{
+          body(i);
+        }
+        catch(...){
+          std::lock_guard<std::mutex> lock(error_mutex);
+          if(i < first_error){
+            first_error = i;
+            error = std::current_exception();
+          }
+          return;
+        }
+      }
+    });
+  }
+
+  WorkerPool::shared().run(tasks);
+
+  if(error){
+    std::rethrow_exception(error);
+  }
+}
@@ -0,0 +1,86 @@
+/*! \file worker_pool.hpp
+Defines a fixed pool of worker threads used to evaluate independent pieces
+of work, e.g. the elements of a map, concurrently.
+ */
+#ifndef WORKER_POOL_HPP
+#define WORKER_POOL_HPP
+
+// system includes
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// module includes
+#include "message_queue.hpp"
+
+/*! \class WorkerPool
+\brief A set of threads running tasks taken from a shared queue.
+
+The thread calling run takes part in the work, so a pool of n workers runs
+up to n + 1 tasks at once, and a pool with no workers runs them serially.
+ */
+class WorkerPool {
+public:
+
+  /*! Construct a pool
+    \param workers the number of worker threads to start
+   */
+  explicit WorkerPool(std::size_t workers);
+
+  /// stop and join the worker threads
+  ~WorkerPool();
+
+  WorkerPool(const WorkerPool &) = delete;
+  WorkerPool & operator=(const WorkerPool &) = delete;
+
+  /// the pool shared by the interpreter, grown on demand with reserve
+  static WorkerPool & shared();
+
+  /// true when called from one of the worker threads of any pool
+  static bool in_worker() noexcept;
+
+  /*! Start more workers if the pool has fewer than requested
+    \param workers the number of worker threads wanted
+   */
+  void reserve(std::size_t workers);
+
+  /// the number of worker threads
+  std::size_t size() const;
+
+  /*! Run tasks and wait for all of them to finish
+    \param tasks the tasks to run, which must not throw
+   */
+  void run(std::vector<std::function<void()> > & tasks);
+
+private:
+
+  struct Batch;
+
+  struct Job {
+    std::function<void()> * task; // nullptr asks the worker to stop
+    Batch * batch;
+  };
+
+  MessageQueue<Job> jobs;
+  std::vector<std::thread> threads;
+  mutable std::mutex threads_mutex;
+
+  void work();
+  static void execute(const Job & job);
+};
+
+/*! \fn parallel_for
+\brief call body(i) for every i in [0, count), split into contiguous chunks
+run on the shared WorkerPool
+
+\param count the number of indices
+\param chunks the number of chunks to split the indices into
+\param body the function to call, which may throw
+\throws the exception raised for the lowest index, after all chunks finish
+ */
+void parallel_for(std::size_t count, std::size_t chunks,
+                  const std::function<void(std::size_t)> & body);
+
+#endif
@@ -0,0 +1,100 @@
+#include "catch.hpp"
+
+#include <atomic>
+#include <functional>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "interpreter.hpp"
+#include "semantic_error.hpp"
+#include "worker_pool.hpp"
+
+static Expression run(Interpreter & interp, const std::string & program){
+
+  std::istringstream iss(program);
+  REQUIRE(interp.parseStream(iss) == true);
+  return interp.evaluate();
+}
+
+TEST_CASE( "Test worker pool", "[worker_pool]" ) {
+
+  WorkerPool pool(3);
+  REQUIRE(pool.size() == 3);
+
+  std::atomic<int> sum(0);
+  std::vector<std::function<void()> > tasks;
+  for(int i = 1; i <= 100; ++i){
+    tasks.push_back([&sum, i]{ sum += i; });
+  }
+  pool.run(tasks);
+  REQUIRE(sum == 5050);
+
+  INFO("reserve only grows the pool");
+  pool.reserve(2);
+  REQUIRE(pool.size() == 3);
+  pool.reserve(4);
+  REQUIRE(pool.size() == 4);
+}
+
+TEST_CASE( "Test parallel for", "[worker_pool]" ) {
+
+  WorkerPool::shared().reserve(3);
+
+  std::vector<int> seen(1000, 0);
+  parallel_for(seen.size(), 4, [&seen](std::size_t i){ seen[i] += 1; });
+  for(auto s : seen){
+    REQUIRE(s == 1);
+  }
+
+  INFO("the exception of the lowest index is raised");
+  try{
+    parallel_for(1000, 4, [](std::size_t i){
+      if((i == 700) || (i == 300)){
+        throw std::runtime_error(std::to_string(i));
+      }
+    });
+    REQUIRE(false);
+  }
+  catch(const std::runtime_error & ex){
+    REQUIRE(std::string(ex.what()) == "300");
+  }
+}
+
+TEST_CASE( "Test parallel map", "[worker_pool]" ) {
+
+  std::string define = "(define f (lambda (x) (+ (* x x) (sin x))))";
+  std::string program = "(map f (range 0 2000 1))";
+
+  Interpreter serial;
+  serial.setMapThreads(1);
+  run(serial, define);
+  Expression expected = run(serial, program);
+
+  Interpreter parallel;
+  parallel.setMapThreads(4);
+  run(parallel, define);
+  REQUIRE(run(parallel, program) == expected);
+
+  INFO("a list bound in the environment is read by every worker");
+  run(parallel, "(define xs (range 0 2000 1))");
+  REQUIRE(run(parallel, "(map f xs)") == expected);
+
+  INFO("call sites in the body, lists included, are shared by the workers");
+  run(parallel, "(define p (lambda (x) (first (list x 1))))");
+  REQUIRE(run(parallel, "(map p (range 0 2000 1))") == run(serial, "(range 0 2000 1)"));
+
+  INFO("the first semantic error is raised");
+  run(parallel, "(define g (lambda (x) (range x 1500 1000)))");
+  std::istringstream iss("(map g (range 0 2000 1))");
+  REQUIRE(parallel.parseStream(iss) == true);
+  REQUIRE_THROWS_AS(parallel.evaluate(), SemanticError);
+
+  INFO("memoized lambdas can be mapped in parallel");
+  run(parallel, "(define h (memoize (lambda (x) (* 2 (first (list x))))))");
+  Expression doubled = run(parallel, "(map h (range 0 1023 1))");
+  Expression twice = run(parallel, "(map h (range 0 1023 1))");
+  REQUIRE(doubled == twice);
+  REQUIRE(run(parallel, "(memo-stats h)") == run(parallel, "(list 1024 1024)"));
+}